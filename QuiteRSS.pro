@@ -55,6 +55,12 @@ TEMPLATE = app
 HEADERS += \
     src/VersionNo.h \
     src/parseobject.h \
+    src/parseworker.h \
+    src/xmlelement.h \
+    src/feedcorpus.h \
+    src/updatebenchmark.h \
+    src/dateparser.h \
+    src/xmldecoder.h \
     src/optionsdialog.h \
     src/newsview/newsview.h \
     src/newsview/newsmodel.h \
@@ -88,6 +94,8 @@ HEADERS += \
     src/application/mainapplication.h \
     src/application/settings.h \
     src/application/logfile.h \
+    src/application/tracer.h \
+    src/application/logging.h \
     src/application/mainwindow.h \
     src/adblock/adblocktreewidget.h \
     src/adblock/adblocksubscription.h \
@@ -119,12 +127,22 @@ HEADERS += \
     src/newsfilters/itemaction.h \
     src/network/sslerrordialog.h \
     src/network/networkmanagerproxy.h \
+    src/network/contentdecoder.h \
+    src/network/timeoutqueue.h \
+    src/network/retrypolicy.h \
+    src/network/standinserver.h \
     src/adblock/adblockmatcher.h \
     src/feedsview/feedsproxymodel.h \
     src/main/globals.h \
 
 SOURCES += \
     src/parseobject.cpp \
+    src/parseworker.cpp \
+    src/xmlelement.cpp \
+    src/feedcorpus.cpp \
+    src/updatebenchmark.cpp \
+    src/dateparser.cpp \
+    src/xmldecoder.cpp \
     src/optionsdialog.cpp \
     src/newsview/newsview.cpp \
     src/newsview/newsmodel.cpp \
@@ -157,6 +175,8 @@ SOURCES += \
     src/application/mainapplication.cpp \
     src/application/settings.cpp \
     src/application/logfile.cpp \
+    src/application/tracer.cpp \
+    src/application/logging.cpp \
     src/application/mainwindow.cpp \
     src/main/globals.cpp \
     src/main/main.cpp \
@@ -190,6 +210,10 @@ SOURCES += \
     src/newsfilters/itemaction.cpp \
     src/network/sslerrordialog.cpp \
     src/network/networkmanagerproxy.cpp \
+    src/network/contentdecoder.cpp \
+    src/network/timeoutqueue.cpp \
+    src/network/retrypolicy.cpp \
+    src/network/standinserver.cpp \
     src/adblock/adblockmatcher.cpp \
     src/feedsview/feedsproxymodel.cpp
 
@@ -213,7 +237,10 @@ CONFIG(debug, debug|release) {
   BUILD_DIR = $$OUT_PWD/debug
 } else {
   BUILD_DIR = $$OUT_PWD/release
-#  DEFINES += QT_NO_DEBUG_OUTPUT
+  # qmake DISABLE_DEBUG_OUTPUT=true compiles debug messages out of release build
+  equals(DISABLE_DEBUG_OUTPUT, true) {
+    DEFINES += QT_NO_DEBUG_OUTPUT
+  }
 }
 
 DESTDIR = $${BUILD_DIR}/target
@@ -236,6 +263,13 @@ include(3rdparty/ganalytics/ganalytics.pri)
 
 os2|win32|mac {
   TARGET = QuiteRSS
+  # zlib bundled with Qt is used for decoding of compressed responses
+  INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+}
+
+unix:!mac {
+  CONFIG += link_pkgconfig
+  PKGCONFIG += zlib
 }
 
 win32 {
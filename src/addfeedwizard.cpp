@@ -408,7 +408,7 @@ void AddFeedWizard::addFeed()
       mainApp->cookieJar()->setCookiesFromUrl(loadedCookies, feedUrlString_);
     }
 
-    emit signalRequestUrl(feedId_, feedUrlString_, QDateTime(), userInfo);
+    emit signalRequestUrl(feedId_, feedUrlString_, "", "", userInfo);
   }
 }
 
@@ -535,7 +535,7 @@ void AddFeedWizard::getUrlDone(int result, int feedId, QString feedUrlStr,
 
             authentication_->setChecked(false);
 
-            emit signalRequestUrl(feedId, linkFeedString, QDateTime(), "");
+            emit signalRequestUrl(feedId, linkFeedString, "", "", "");
           }
         }
       }
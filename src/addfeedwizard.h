@@ -56,7 +56,8 @@ signals:
   void xmlReadyParse(QByteArray data, int feedId,
                      QDateTime dtReply, QString codecName);
   void signalRequestUrl(int feedId, QString urlString,
-                        QDateTime date, QString userInfo);
+                        QString etag, QString lastModified,
+                        QString userInfo);
 
 protected:
   virtual bool validateCurrentPage();
@@ -23,14 +23,175 @@
 #include <QDesktopServices>
 #endif
 #include <QDir>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
 
 #include "globals.h"
 #include "settings.h"
 
+#define LOG_BUFFER_MAX_LINES 10000
+
+/** @brief Thread writing buffered log messages into debug.log
+ *----------------------------------------------------------------------------*/
+class LogWriter : public QThread
+{
+protected:
+  void run();
+};
+
+static QMutex logMutex;
+// Serializes writes into file. Recursive, as message emitted while writing
+// after stop is written directly by the same thread
+static QMutex logFileMutex(QMutex::Recursive);
+static QWaitCondition logCondition;
+static QStringList logBuffer;
+static int logDropped = 0;
+static bool logStopping = false;
+static LogWriter *logWriter = 0;
+
+void LogWriter::run()
+{
+  QFile file;
+  forever {
+    QStringList lines;
+    int dropped;
+    bool stopping;
+    {
+      QMutexLocker locker(&logMutex);
+      while (logBuffer.isEmpty() && !logStopping)
+        logCondition.wait(&logMutex);
+      lines.swap(logBuffer);
+      dropped = logDropped;
+      logDropped = 0;
+      stopping = logStopping;
+    }
+
+    {
+      QMutexLocker locker(&logFileMutex);
+      LogFile::writeLines(&file, lines, dropped);
+    }
+    if (stopping)
+      break;
+  }
+  file.close();
+}
+
 LogFile::LogFile()
 {
 }
 
+/** @brief Stop writer thread after writing all buffered messages
+ *
+ * Messages after stop are written directly by thread emitting them
+ *----------------------------------------------------------------------------*/
+void LogFile::stop()
+{
+  {
+    QMutexLocker locker(&logMutex);
+    if (!logWriter || logStopping)
+      return;
+    logStopping = true;
+    logCondition.wakeOne();
+  }
+  logWriter->wait();
+  delete logWriter;
+  logWriter = 0;
+}
+
+/** @brief Append lines to log file, rotate file when it exceeds maxLogFileSize
+ *----------------------------------------------------------------------------*/
+void LogFile::writeLines(QFile *file, const QStringList &lines, int dropped)
+{
+  if (lines.isEmpty() && !dropped)
+    return;
+
+  QString fileName = globals.dataDir_ + "/debug.log";
+  if (!file->isOpen()) {
+    file->setFileName(fileName);
+    file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+  }
+  if (file->isOpen() && (file->size() >= (qint64)maxLogFileSize)) {
+    file->close();
+    QFile::remove(fileName + ".1");
+    QFile::rename(fileName, fileName + ".1");
+    file->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+  }
+  if (!file->isOpen())
+    return;
+
+  QByteArray data;
+  if (dropped) {
+    data.append(QString("%1 WARNING: %2 messages dropped\n").
+                arg(QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss.zzz")).
+                arg(dropped).toUtf8());
+  }
+  foreach (const QString &line, lines) {
+    data.append(line.toUtf8());
+  }
+  file->write(data);
+  file->flush();
+}
+
+/** @brief Queue message for writer thread
+ *
+ * Writer thread is started with first message. When buffer is full,
+ * oldest messages are dropped instead of blocking emitting thread
+ *----------------------------------------------------------------------------*/
+void LogFile::writeMessage(QtMsgType type, const QString &msg)
+{
+  QString line = QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss.zzz");
+  switch (type) {
+  case QtDebugMsg:
+    line.append(" DEBUG: ");
+    break;
+  case QtWarningMsg:
+    line.append(" WARNING: ");
+    break;
+  case QtCriticalMsg:
+    line.append(" CRITICAL: ");
+    break;
+  case QtFatalMsg:
+    line.append(" FATAL: ");
+    break;
+  default:
+    return;
+  }
+  line.append(msg).append('\n');
+
+  bool direct = false;
+  {
+    QMutexLocker locker(&logMutex);
+    if (logStopping) {
+      direct = true;
+    } else {
+      if (!logWriter) {
+        logWriter = new LogWriter();
+        logWriter->start(QThread::LowestPriority);
+      }
+      if (logBuffer.count() >= LOG_BUFFER_MAX_LINES) {
+        logBuffer.removeFirst();
+        logDropped++;
+      }
+      logBuffer.append(line);
+      logCondition.wakeOne();
+    }
+  }
+
+  // Buffer mutex isn't held here, writing can emit messages itself
+  if (direct) {
+    QMutexLocker locker(&logFileMutex);
+    QFile file;
+    writeLines(&file, QStringList() << line, 0);
+    file.close();
+  }
+
+  if (type == QtFatalMsg) {
+    stop();
+    qApp->exit(EXIT_FAILURE);
+  }
+}
+
 #ifdef HAVE_QT5
 void LogFile::msgHandler(QtMsgType type, const QMessageLogContext &, const QString &msg)
 {
@@ -44,43 +205,7 @@ void LogFile::msgHandler(QtMsgType type, const QMessageLogContext &, const QStri
       return;
   }
 
-  QFile file;
-  file.setFileName(globals.dataDir_ + "/debug.log");
-  QIODevice::OpenMode openMode = QIODevice::WriteOnly | QIODevice::Text;
-
-  if (file.exists() && (file.size() < (qint64)maxLogFileSize)) {
-    openMode |= QIODevice::Append;
-  }
-
-  file.open(openMode);
-
-  QTextStream stream;
-  stream.setDevice(&file);
-  stream.setCodec("UTF-8");
-
-  if (file.isOpen()) {
-    QString currentDateTime = QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss.zzz");
-    switch (type) {
-    case QtDebugMsg:
-      stream << currentDateTime << " DEBUG: " << msg << "\n";
-      break;
-    case QtWarningMsg:
-      stream << currentDateTime << " WARNING: " << msg << "\n";
-      break;
-    case QtCriticalMsg:
-      stream << currentDateTime << " CRITICAL: " << msg << "\n";
-      break;
-    case QtFatalMsg:
-      stream << currentDateTime << " FATAL: " << msg << "\n";
-      qApp->exit(EXIT_FAILURE);
-    default:
-      break;
-    }
-
-    stream.flush();
-    file.flush();
-    file.close();
-  }
+  writeMessage(type, msg);
 }
 #else
 void LogFile::msgHandler(QtMsgType type, const char *msg)
@@ -95,42 +220,6 @@ void LogFile::msgHandler(QtMsgType type, const char *msg)
       return;
   }
 
-  QFile file;
-  file.setFileName(globals.dataDir_ + "/debug.log");
-  QIODevice::OpenMode openMode = QIODevice::WriteOnly | QIODevice::Text;
-
-  if (file.exists() && (file.size() < (qint64)maxLogFileSize)) {
-    openMode |= QIODevice::Append;
-  }
-
-  file.open(openMode);
-
-  QTextStream stream;
-  stream.setDevice(&file);
-  stream.setCodec("UTF-8");
-
-  if (file.isOpen()) {
-    QString currentDateTime = QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss.zzz");
-    switch (type) {
-    case QtDebugMsg:
-      stream << currentDateTime << " DEBUG: " << QString::fromUtf8(msg) << "\n";
-      break;
-    case QtWarningMsg:
-      stream << currentDateTime << " WARNING: " << QString::fromUtf8(msg) << "\n";
-      break;
-    case QtCriticalMsg:
-      stream << currentDateTime << " CRITICAL: " << QString::fromUtf8(msg) << "\n";
-      break;
-    case QtFatalMsg:
-      stream << currentDateTime << " FATAL: " << QString::fromUtf8(msg) << "\n";
-      qApp->exit(EXIT_FAILURE);
-    default:
-      break;
-    }
-
-    stream.flush();
-    file.flush();
-    file.close();
-  }
+  writeMessage(type, QString::fromUtf8(msg));
 }
 #endif
@@ -22,10 +22,15 @@
 #include <QFile>
 #include <QDateTime>
 #include <QDebug>
-#include <QTextStream>
+#include <QStringList>
 
 const size_t maxLogFileSize = 1 * 1024 * 1024; //1 MB
 
+/** @brief Message handler writing debug.log
+ *
+ * Messages are buffered and written by background thread, so emitting
+ * thread doesn't wait for file I/O
+ *----------------------------------------------------------------------------*/
 class LogFile
 {
 public:
@@ -34,10 +39,16 @@ public:
 #else
   static void msgHandler(QtMsgType type, const char *msg);
 #endif
+  static void stop();
 
 private:
   explicit LogFile();
 
+  static void writeMessage(QtMsgType type, const QString &msg);
+  static void writeLines(QFile *file, const QStringList &lines, int dropped);
+
+  friend class LogWriter;
+
 };
 
 #endif // LOGFILE_H
@@ -0,0 +1,45 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(lcNetwork, "quiterss.network")
+Q_LOGGING_CATEGORY(lcParse, "quiterss.parse")
+Q_LOGGING_CATEGORY(lcDatabase, "quiterss.database")
+Q_LOGGING_CATEGORY(lcFilters, "quiterss.filters")
+Q_LOGGING_CATEGORY(lcUi, "quiterss.ui")
+
+#if QT_VERSION < 0x050200
+bool LogCategory::debugEnabled_ = false;
+#endif
+
+/** @brief Enable debug messages of categories
+ * @param debugOutput debug output is enabled as a whole
+ * @param rules Qt filter rules separated by ';', not supported with Qt 4
+ *----------------------------------------------------------------------------*/
+void Logging::setRules(bool debugOutput, const QString &rules)
+{
+#if QT_VERSION >= 0x050200
+  QString filterRules = QString("quiterss.*.debug=%1").arg(debugOutput ? "true" : "false");
+  if (debugOutput && !rules.isEmpty())
+    filterRules += "\n" + QString(rules).replace(';', '\n');
+  QLoggingCategory::setFilterRules(filterRules);
+#else
+  Q_UNUSED(rules)
+  LogCategory::debugEnabled_ = debugOutput;
+#endif
+}
@@ -0,0 +1,76 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QDebug>
+#include <QString>
+
+/** @brief Logging categories of feed update path
+ *
+ * Debug messages of disabled category are not formatted at all. All
+ * categories follow "noDebugOutput" setting, "logRules" setting narrows
+ * them with Qt filter rules, e.g. "quiterss.parse.debug=false".
+ * Build with DISABLE_DEBUG_OUTPUT=true compiles debug messages out
+ *----------------------------------------------------------------------------*/
+#if QT_VERSION >= 0x050200
+#include <QLoggingCategory>
+#else
+// Qt 4: category is enabled together with debug output
+class LogCategory
+{
+public:
+  explicit LogCategory(const char *name) : name_(name) {}
+  const char *categoryName() const { return name_; }
+  bool isDebugEnabled() const { return debugEnabled_; }
+
+  static bool debugEnabled_;
+
+private:
+  const char *name_;
+
+};
+
+#define Q_DECLARE_LOGGING_CATEGORY(name) \
+  const LogCategory &name();
+#define Q_LOGGING_CATEGORY(name, string) \
+  const LogCategory &name() { static const LogCategory category(string); return category; }
+
+#if defined(QT_NO_DEBUG_OUTPUT)
+#define qCDebug(category) qDebug()
+#else
+#define qCDebug(category) \
+  for (bool qt_category_enabled = category().isDebugEnabled(); \
+       qt_category_enabled; qt_category_enabled = false) \
+    qDebug()
+#endif
+#define qCWarning(category) qWarning()
+#endif
+
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)
+Q_DECLARE_LOGGING_CATEGORY(lcParse)
+Q_DECLARE_LOGGING_CATEGORY(lcDatabase)
+Q_DECLARE_LOGGING_CATEGORY(lcFilters)
+Q_DECLARE_LOGGING_CATEGORY(lcUi)
+
+namespace Logging
+{
+  void setRules(bool debugOutput, const QString &rules);
+}
+
+#endif // LOGGING_H
@@ -25,6 +25,7 @@
 #include "adblockmanager.h"
 #include "settings.h"
 #include "splashscreen.h"
+#include "tracer.h"
 #include "updatefeeds.h"
 #include "VersionNo.h"
 
@@ -135,6 +136,14 @@ void MainApplication::receiveMessage(const QString &message)
         mainWindow_->showWindows();
       }
       if (param == "--exit") mainWindow_->quitApp();
+      if (param == "--replay-corpus") updateFeeds_->startCorpusReplay();
+      if (param == "--benchmark-update") updateFeeds_->startUpdateBenchmark();
+      if (param == "--bench-dates") updateFeeds_->startDateBenchmark();
+      if (param == "--bench-decoder") updateFeeds_->startDecoderBenchmark();
+      if (param == "--check-query-plans") {
+        QSqlDatabase db = QSqlDatabase::database();
+        Database::checkQueryPlans(db);
+      }
       if (param.contains("feed:", Qt::CaseInsensitive)) {
         QClipboard *clipboard = QApplication::clipboard();
         if (param.contains("https://", Qt::CaseInsensitive)) {
@@ -156,9 +165,12 @@ void MainApplication::createSettings()
   settings.beginGroup("Settings");
   storeDBMemory_ = settings.value("storeDBMemory", true).toBool();
   isSaveDataLastFeed_ = settings.value("createLastFeed", false).toBool();
+  isRecordCorpus_ = settings.value("recordCorpus", false).toBool();
   styleApplication_ = settings.value("styleApplication", "greenStyle_").toString();
   showSplashScreen_ = settings.value("showSplashScreen", true).toBool();
   updateFeedsStartUp_ = settings.value("autoUpdatefeedsStartUp", false).toBool();
+  if (settings.value("traceOutput", false).toBool())
+    Tracer::start(dataDir() + "/trace.json");
 
   QString strLang;
   QString strLocalLang = QLocale::system().name();
@@ -247,6 +259,7 @@ void MainApplication::quitApplication()
 {
   qWarning() << "quitApplication 1";
   delete mainWindow_;
+  Tracer::stop();
   qWarning() << "quitApplication 2";
   delete networkManager_;
   delete cookieJar_;
@@ -344,6 +357,11 @@ bool MainApplication::isSaveDataLastFeed() const
   return isSaveDataLastFeed_;
 }
 
+bool MainApplication::isRecordCorpus() const
+{
+  return isRecordCorpus_;
+}
+
 bool MainApplication::storeDBMemory() const
 {
   return storeDBMemory_;
@@ -65,6 +65,7 @@ public:
   bool storeDBMemory() const;
   bool dbFileExists() const { return dbFileExists_; }
   bool isSaveDataLastFeed() const;
+  bool isRecordCorpus() const;
   void sqlQueryExec(const QString &query);
 
   MainWindow *mainWindow();
@@ -125,6 +126,7 @@ private:
   bool storeDBMemory_;
   bool dbFileExists_;
   bool isSaveDataLastFeed_;
+  bool isRecordCorpus_;
   QString styleApplication_;
   bool showSplashScreen_;
   bool updateFeedsStartUp_;
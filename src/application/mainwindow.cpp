@@ -32,6 +32,8 @@
 #include "newsfiltersdialog.h"
 #include "webpage.h"
 #include "settings.h"
+#include "tracer.h"
+#include "logging.h"
 
 #if defined(Q_OS_WIN)
 #include <windows.h>
@@ -52,7 +54,6 @@ MainWindow::MainWindow(QWidget *parent)
   , feedsFilterAction_(NULL)
   , newsFilterAction_(NULL)
   , newsView_(NULL)
-  , updateTimeCount_(0)
 #if defined(HAVE_QT5) || defined(HAVE_PHONON)
   , mediaPlayer_(NULL)
 #endif
@@ -2049,6 +2050,7 @@ void MainWindow::loadSettings()
   updateFeedsEnable_ = settings.value("autoUpdatefeeds", false).toBool();
   updateFeedsInterval_ = settings.value("autoUpdatefeedsTime", 10).toInt();
   updateFeedsIntervalType_ = settings.value("autoUpdatefeedsInterval", 0).toInt();
+  adaptiveUpdateFeeds_ = settings.value("adaptiveUpdateFeeds", true).toBool();
 
   openingFeedAction_ = settings.value("openingFeedAction", 0).toInt();
   openNewsWebViewOn_ = settings.value("openNewsWebViewOn", true).toBool();
@@ -2756,7 +2758,7 @@ void MainWindow::slotImportFeeds()
     return;
   }
 
-  qDebug() << "import file:" << fileName;
+  qCDebug(lcUi) << "import file:" << fileName;
 
   QFile file(fileName);
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -3068,9 +3070,29 @@ void MainWindow::slotRecountCategoryCounts(QList<int> deletedList, QList<int> st
  * Slot is called by UpdateDelayer after some delay
  * @param feedId Feed identifier to update
  * @param changed Flag indicating that feed is updated indeed
+ * @param nextUpdate Time of next automatic update, 0 - no update,
+ *   -1 - not calculated yet
+ * @param publishInterval Learned publish interval of feed, -1 - unknown
  *---------------------------------------------------------------------------*/
-void MainWindow::slotUpdateFeed(int feedId, bool changed, int newCount, bool finish)
+void MainWindow::slotUpdateFeed(int feedId, bool changed, int newCount, bool finish,
+                                qint64 nextUpdate, int publishInterval)
 {
+  TraceSpan span("updateFeedView", feedId);
+
+  // Next update time is calculated and saved by update thread
+  if (publishInterval >= 0)
+    feedsPublishInterval_.insert(feedId, publishInterval);
+  if (nextUpdate < 0) {
+    scheduleFeedUpdate(feedId, feedUpdateInterval(feedId));
+  } else {
+    unscheduleFeedUpdate(feedId);
+    if (nextUpdate > 0) {
+      updateFeedsQueue_.insert(nextUpdate, feedId);
+      updateFeedsDueTime_.insert(feedId, nextUpdate);
+    }
+  }
+  restartUpdateFeedsTimer();
+
   if (finish) {
     emit signalShowNotification();
     progressBar_->hide();
@@ -3866,6 +3888,8 @@ void MainWindow::showOptionDlg(int index)
   else if (updateFeedsIntervalType_ == 1)
     updateInterval = updateInterval*60*60;
   updateIntervalSec_ = updateInterval;
+  emit signalUpdateSettings(updateSettings());
+  initUpdateFeedsQueue();
 
   openingFeedAction_ = optionsDialog_->getOpeningFeed();
   openNewsWebViewOn_ = optionsDialog_->openNewsWebViewOn_->isChecked();
@@ -4097,19 +4121,6 @@ void MainWindow::initUpdateFeeds()
     }
   }
 
-  q.exec("SELECT id, updateInterval, updateIntervalType FROM feeds WHERE xmlUrl != '' AND updateIntervalEnable == 1");
-  while (q.next()) {
-    int updateInterval = q.value(1).toInt();
-    int updateIntervalType = q.value(2).toInt();
-    if (updateIntervalType == 0)
-      updateInterval = updateInterval*60;
-    else if (updateIntervalType == 1)
-      updateInterval = updateInterval*60*60;
-
-    updateFeedsIntervalSec_.insert(q.value(0).toInt(), updateInterval);
-    updateFeedsTimeCount_.insert(q.value(0).toInt(), 0);
-  }
-
   int updateInterval = updateFeedsInterval_;
   if (updateFeedsIntervalType_ == 0)
     updateInterval = updateInterval*60;
@@ -4118,36 +4129,156 @@ void MainWindow::initUpdateFeeds()
   updateIntervalSec_ = updateInterval;
 
   updateFeedsTimer_ = new QTimer(this);
+  updateFeedsTimer_->setSingleShot(true);
   connect(updateFeedsTimer_, SIGNAL(timeout()),
           this, SLOT(slotGetFeedsTimer()));
-  updateFeedsTimer_->start(1000);
+
+  initUpdateFeedsQueue();
 }
-// ----------------------------------------------------------------------------
-void MainWindow::slotGetFeedsTimer()
+
+/** @brief Fill queue of automatic updates from next update time saved in DB
+ *---------------------------------------------------------------------------*/
+void MainWindow::initUpdateFeedsQueue()
 {
-  if (updateFeedsEnable_) {
-    updateTimeCount_++;
-    if (updateTimeCount_ >= updateIntervalSec_) {
-      updateTimeCount_ = 0;
+  updateFeedsQueue_.clear();
+  updateFeedsDueTime_.clear();
 
-      emit signalGetAllFeedsTimer();
-    }
-  } else {
-    updateTimeCount_ = 0;
+  QSqlDatabase db = QSqlDatabase::database();
+  db.transaction();
+  QSqlQuery q;
+  q.exec("SELECT id, updateIntervalEnable, updateInterval, updateIntervalType, nextUpdate "
+         "FROM feeds WHERE xmlUrl != '' AND disableUpdate == 0");
+  while (q.next()) {
+    int feedId = q.value(0).toInt();
+    int interval = feedUpdateInterval(q.value(1), q.value(2).toInt(), q.value(3).toInt(),
+                                      feedsPublishInterval_.value(feedId, 0),
+                                      updateSettings());
+    scheduleFeedUpdate(feedId, interval, q.value(4).toLongLong());
   }
+  db.commit();
 
-  QMapIterator<int, int> iterator(updateFeedsTimeCount_);
-  while (iterator.hasNext()) {
-    iterator.next();
-    int feedId = iterator.key();
-    updateFeedsTimeCount_[feedId]++;
-    if (updateFeedsTimeCount_[feedId] >= updateFeedsIntervalSec_[feedId]) {
-      updateFeedsTimeCount_[feedId] = 0;
+  restartUpdateFeedsTimer();
+}
 
-      emit signalGetFeedTimer(feedId);
-    }
+/** @brief Interval of automatic update of feed in seconds, 0 - no update
+ *---------------------------------------------------------------------------*/
+int MainWindow::feedUpdateInterval(int feedId)
+{
+  QModelIndex index = feedsModel_->indexById(feedId);
+  if (!index.isValid() || feedsModel_->isFolder(index) ||
+      feedsModel_->dataField(index, "disableUpdate").toInt())
+    return 0;
+
+  return feedUpdateInterval(feedsModel_->dataField(index, "updateIntervalEnable"),
+                            feedsModel_->dataField(index, "updateInterval").toInt(),
+                            feedsModel_->dataField(index, "updateIntervalType").toInt(),
+                            feedsPublishInterval_.value(feedId, 0),
+                            updateSettings());
+}
+
+/** @brief Global settings of automatic update
+ *---------------------------------------------------------------------------*/
+UpdateSettings MainWindow::updateSettings() const
+{
+  UpdateSettings settings;
+  settings.enabled = updateFeedsEnable_;
+  settings.intervalSec = updateIntervalSec_;
+  settings.adaptive = adaptiveUpdateFeeds_;
+  return settings;
+}
+
+/** @brief Interval of automatic update from settings of feed
+ * @details Update thread calls it with own copy of global settings
+ *---------------------------------------------------------------------------*/
+int MainWindow::feedUpdateInterval(const QVariant &updateEnable, int updateInterval,
+                                   int updateIntervalType, int publishInterval,
+                                   const UpdateSettings &settings)
+{
+  // Own interval of feed
+  if (updateEnable.toInt() == 1) {
+    if (updateIntervalType == 0)
+      updateInterval = updateInterval*60;
+    else if (updateIntervalType == 1)
+      updateInterval = updateInterval*60*60;
+    return qMax(updateInterval, 1);
+  }
+  // Automatic update is disabled for feed
+  if (!updateEnable.isNull() && (updateEnable.toInt() == 0))
+    return 0;
+
+  if (!settings.enabled)
+    return 0;
+
+  int interval = qMax(settings.intervalSec, 1);
+  if (settings.adaptive && (publishInterval > 0)) {
+    // Check twice per expected publication, but not more often than
+    // global interval and at least once a day
+    interval = qBound(interval, publishInterval / 2,
+                      qMax(interval, ADAPTIVE_UPDATE_MAX_INTERVAL));
+  }
+  return interval;
+}
+
+/** @brief Put feed in queue of automatic updates
+ * @param interval Update interval in seconds, 0 - remove feed from queue
+ * @param dueTime Saved time of next update, 0 - now plus interval
+ * @details Time is saved into base by update thread when update of feed
+ *   is finished
+ *---------------------------------------------------------------------------*/
+void MainWindow::scheduleFeedUpdate(int feedId, int interval, qint64 dueTime)
+{
+  unscheduleFeedUpdate(feedId);
+  if (interval <= 0)
+    return;
+
+  qint64 currentTime = Common::currentSecsSinceEpoch();
+  if ((dueTime <= 0) || (dueTime > currentTime + interval))
+    dueTime = currentTime + interval;
+
+  updateFeedsQueue_.insert(dueTime, feedId);
+  updateFeedsDueTime_.insert(feedId, dueTime);
+}
+
+void MainWindow::unscheduleFeedUpdate(int feedId)
+{
+  QHash<int,qint64>::iterator it = updateFeedsDueTime_.find(feedId);
+  if (it != updateFeedsDueTime_.end()) {
+    updateFeedsQueue_.remove(it.value(), feedId);
+    updateFeedsDueTime_.erase(it);
   }
 }
+
+/** @brief Arm timer for the nearest automatic update
+ *---------------------------------------------------------------------------*/
+void MainWindow::restartUpdateFeedsTimer()
+{
+  if (updateFeedsQueue_.isEmpty()) {
+    updateFeedsTimer_->stop();
+    return;
+  }
+
+  qint64 delay = updateFeedsQueue_.begin().key() - Common::currentSecsSinceEpoch();
+  // Wake up at least once a day, also guards against int overflow
+  delay = qBound(qint64(0), delay, qint64(24*60*60));
+  updateFeedsTimer_->start(int(delay) * 1000);
+}
+// ----------------------------------------------------------------------------
+void MainWindow::slotGetFeedsTimer()
+{
+  qint64 currentTime = Common::currentSecsSinceEpoch();
+  while (!updateFeedsQueue_.isEmpty() &&
+         (updateFeedsQueue_.begin().key() <= currentTime)) {
+    int feedId = updateFeedsQueue_.begin().value();
+    unscheduleFeedUpdate(feedId);
+
+    emit signalGetFeedTimer(feedId);
+
+    // Next time is refined when update is finished
+    scheduleFeedUpdate(feedId, feedUpdateInterval(feedId));
+  }
+
+  restartUpdateFeedsTimer();
+}
 /** @brief Process update feed action
  *---------------------------------------------------------------------------*/
 void MainWindow::slotGetFeed()
@@ -4169,7 +4300,6 @@ void MainWindow::slotGetFeed()
           if (!feedsModel_->dataField(index, "disableUpdate").toBool()) {
             emit signalGetFeed(feedsModel_->dataField(index, "id").toInt(),
                                feedsModel_->dataField(index, "xmlUrl").toString(),
-                               feedsModel_->dataField(index, "lastBuildDate").toDateTime(),
                                feedsModel_->dataField(index, "authentication").toInt());
           }
         }
@@ -4181,7 +4311,6 @@ void MainWindow::slotGetFeed()
         idList.append(idFeed);
         emit signalGetFeed(feedsModel_->dataField(index, "id").toInt(),
                            feedsModel_->dataField(index, "xmlUrl").toString(),
-                           feedsModel_->dataField(index, "lastBuildDate").toDateTime(),
                            feedsModel_->dataField(index, "authentication").toInt());
       }
     }
@@ -5479,6 +5608,11 @@ void MainWindow::showFeedPropertiesDlg()
   q.addBindValue(feedId);
   q.exec();
 
+  // Validators of the old URL are useless for the new one
+  if (properties.general.url != feedsModel_->dataField(index, "xmlUrl").toString()) {
+    q.exec(QString("UPDATE feeds SET etag='', lastModified='' WHERE id=='%1'").arg(feedId));
+  }
+
 
   indexColumnsStr = "";
   if ((properties.column.columns != properties.columnDefault.columns) ||
@@ -5617,13 +5751,6 @@ void MainWindow::showFeedPropertiesDlg()
     feedsModel_->setData(indexUpdateInterval, properties.general.updateInterval);
     feedsModel_->setData(indexIntervalType, properties.general.intervalType);
 
-    int updateInterval = properties.general.updateInterval;
-    int updateIntervalType = properties.general.intervalType;
-    if (updateIntervalType == 0)
-      updateInterval = updateInterval*60;
-    else if (updateIntervalType == 1)
-      updateInterval = updateInterval*60*60;
-
     if (!isFeed) {
       QQueue<int> parentIds;
       parentIds.enqueue(feedId);
@@ -5653,27 +5780,16 @@ void MainWindow::showFeedPropertiesDlg()
           feedsModel_->setData(indexIntervalType, properties.general.intervalType);
 
           if (!xmlUrl.isEmpty()) {
-            if (properties.general.updateEnable) {
-              updateFeedsIntervalSec_.insert(id, updateInterval);
-              updateFeedsTimeCount_.insert(id, 0);
-            } else {
-              updateFeedsIntervalSec_.remove(id);
-              updateFeedsTimeCount_.remove(id);
-            }
+            scheduleFeedUpdate(id, feedUpdateInterval(id));
           } else {
             parentIds.enqueue(id);
           }
         }
       }
     } else {
-      if (properties.general.updateEnable) {
-        updateFeedsIntervalSec_.insert(feedId, updateInterval);
-        updateFeedsTimeCount_.insert(feedId, 0);
-      } else {
-        updateFeedsIntervalSec_.remove(feedId);
-        updateFeedsTimeCount_.remove(feedId);
-      }
+      scheduleFeedUpdate(feedId, feedUpdateInterval(feedId));
     }
+    restartUpdateFeedsTimer();
   } else {
     q.prepare("UPDATE feeds SET updateIntervalEnable = -1 WHERE id == ?");
     q.addBindValue(feedId);
@@ -5682,8 +5798,8 @@ void MainWindow::showFeedPropertiesDlg()
     QPersistentModelIndex indexUpdateEnable = feedsModel_->indexSibling(index, "updateIntervalEnable");
     feedsModel_->setData(indexUpdateEnable, "-1");
 
-    updateFeedsIntervalSec_.remove(feedId);
-    updateFeedsTimeCount_.remove(feedId);
+    scheduleFeedUpdate(feedId, feedUpdateInterval(feedId));
+    restartUpdateFeedsTimer();
   }
 
   if (properties.general.image != properties_tmp.general.image) {
@@ -7438,10 +7554,10 @@ void MainWindow::slotCategoriesClicked(QTreeWidgetItem *item, int, bool createTa
       currentNewsTab->categoryFilterStr_ = "feedId > 0 AND deleted = 0 AND read < 2";
       break;
     case NewsTabWidget::TabTypeStar:
-      currentNewsTab->categoryFilterStr_ = "feedId > 0 AND deleted = 0 AND starred = 1";
+      currentNewsTab->categoryFilterStr_ = kStarredNewsFilter;
       break;
     case NewsTabWidget::TabTypeDel:
-      currentNewsTab->categoryFilterStr_ = "feedId > 0 AND deleted = 1";
+      currentNewsTab->categoryFilterStr_ = kDeletedNewsFilter;
       break;
     case NewsTabWidget::TabTypeLabel:
       if (currentNewsTab->labelId_ != 0) {
@@ -59,6 +59,20 @@
 
 #define MAX_TAB_WIDTH 150
 
+// Number of latest news used to learn how often feed publishes
+#define ADAPTIVE_UPDATE_NEWS_COUNT 20
+// Upper bound of adaptive update interval, seconds
+#define ADAPTIVE_UPDATE_MAX_INTERVAL (24*60*60)
+
+/** Global settings of automatic update, update thread keeps own copy */
+struct UpdateSettings {
+  bool enabled;
+  int intervalSec;
+  bool adaptive;
+};
+
+Q_DECLARE_METATYPE(UpdateSettings)
+
 enum FeedReedType {
   FeedReadSwitchingFeed,
   FeedReadClosingTab,
@@ -231,6 +245,11 @@ public:
   bool avoidOldNews_;
   QDate avoidedOldNewsDate_;
 
+  UpdateSettings updateSettings() const;
+  static int feedUpdateInterval(const QVariant &updateEnable, int updateInterval,
+                                int updateIntervalType, int publishInterval,
+                                const UpdateSettings &settings);
+
   bool autoLoadImages_;
   bool openLinkInBackground_;
   bool isOpeningLink_;  //!< Flag - link is being opened
@@ -303,7 +322,8 @@ public slots:
   void showWindows(bool trayClick = false);
   void quitApp();
   void myEmptyWorkingSet();
-  void slotUpdateFeed(int feedId, bool changed, int newCount, bool finish);
+  void slotUpdateFeed(int feedId, bool changed, int newCount, bool finish,
+                      qint64 nextUpdate = -1, int publishInterval = -1);
   void slotFeedCountsUpdate(FeedCountStruct counts);
   void slotUpdateNews(int refresh);
   void slotUpdateStatus(int feedId, bool changed = true);
@@ -319,14 +339,15 @@ signals:
   void signalQuitApp();
   void signalPlaceToTray();
   void signalGetFeedTimer(int feedId);
-  void signalGetAllFeedsTimer();
-  void signalGetFeed(int feedId, QString feedUrl, QDateTime date, int auth);
+  void signalUpdateSettings(UpdateSettings settings);
+  void signalGetFeed(int feedId, QString feedUrl, int auth);
   void signalGetFeedsFolder(QString query);
   void signalGetAllFeeds();
   void signalStopUpdate();
   void signalImportFeeds(QByteArray xmlData);
   void signalRequestUrl(int feedId, QString urlString,
-                        QDateTime date, QString userInfo);
+                        QString etag, QString lastModified,
+                        QString userInfo);
   void faviconRequestUrl(QString urlString, QString feedUrl);
   void signalIconFeedReady(QString feedUrl, QByteArray faviconData);
   void signalSetCurrentTab(int index, bool updateTab = false);
@@ -527,6 +548,11 @@ private:
   void recountFeedCategories(const QList<int> &categoriesList);
   void creatFeedTab(int feedId, int feedParId);
   void initUpdateFeeds();
+  void initUpdateFeedsQueue();
+  int feedUpdateInterval(int feedId);
+  void scheduleFeedUpdate(int feedId, int interval, qint64 dueTime = 0);
+  void unscheduleFeedUpdate(int feedId);
+  void restartUpdateFeedsTimer();
   void addOurFeed();
 
   int addTab(NewsTabWidget *widget);
@@ -687,13 +713,14 @@ private:
 
   QTimer *updateFeedsTimer_;
   int updateIntervalSec_;
-  int updateTimeCount_;
   bool updateFeedsEnable_;
   int  updateFeedsInterval_;
   int  updateFeedsIntervalType_;
+  bool adaptiveUpdateFeeds_;
   QList<int> feedIdList_;
-  QMap<int,int> updateFeedsIntervalSec_;
-  QMap<int,int> updateFeedsTimeCount_;
+  QHash<int,int> feedsPublishInterval_;
+  QMultiMap<qint64,int> updateFeedsQueue_;
+  QHash<int,qint64> updateFeedsDueTime_;
 
   bool minimizingTray_;
   bool closingTray_;
@@ -0,0 +1,190 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QTextStream>
+#include <QThread>
+
+#define TRACE_MAX_EVENTS 1000000
+
+bool Tracer::enabled_ = false;
+
+static QMutex traceMutex;
+static QElapsedTimer traceClock;
+static QString traceFileName;
+static QList<QByteArray> traceEvents;
+static QHash<quintptr, QString> traceThreads;
+
+/** @brief Start collecting spans, file is written by stop()
+ *----------------------------------------------------------------------------*/
+void Tracer::start(const QString &fileName)
+{
+  QMutexLocker locker(&traceMutex);
+  traceFileName = fileName;
+  traceEvents.clear();
+  traceThreads.clear();
+  traceClock.start();
+  enabled_ = true;
+}
+
+/** @brief Stop collecting spans and write trace file
+ *----------------------------------------------------------------------------*/
+void Tracer::stop()
+{
+  QMutexLocker locker(&traceMutex);
+  if (!enabled_)
+    return;
+  enabled_ = false;
+
+  QFile file(traceFileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << "Cannot write trace file:" << traceFileName;
+    return;
+  }
+
+  qint64 pid = QCoreApplication::applicationPid();
+  file.write("{\"traceEvents\":[\n");
+  QHash<quintptr, QString>::const_iterator it = traceThreads.constBegin();
+  for (; it != traceThreads.constEnd(); ++it) {
+    QString name = it.value();
+    name.replace('\\', "\\\\").replace('"', "\\\"");
+    file.write(QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,"
+                       "\"args\":{\"name\":\"%3\"}},\n").
+               arg(pid).arg(it.key()).arg(name).toUtf8());
+  }
+  for (int i = 0; i < traceEvents.count(); ++i) {
+    file.write(traceEvents.at(i));
+    file.write((i < traceEvents.count() - 1) ? ",\n" : "\n");
+  }
+  file.write("]}\n");
+  file.close();
+
+  qWarning() << "Trace written:" << traceFileName << traceEvents.count() << "events";
+  traceEvents.clear();
+  traceThreads.clear();
+}
+
+/** @brief Microseconds since start of tracing
+ *----------------------------------------------------------------------------*/
+qint64 Tracer::timestamp()
+{
+  return traceClock.nsecsElapsed() / 1000;
+}
+
+/** @brief Add span of current thread from start till now
+ *----------------------------------------------------------------------------*/
+void Tracer::addSpan(const char *name, qint64 start, int feedId)
+{
+  if (!enabled_ || (start < 0))
+    return;
+
+  Event event;
+  event.name = name;
+  event.start = start;
+  event.duration = timestamp() - start;
+  event.feedId = feedId;
+  event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  event.asyncId = 0;
+  addEvent(event);
+}
+
+/** @brief Add span that may overlap other spans of thread, e.g. network request
+ *----------------------------------------------------------------------------*/
+void Tracer::addAsyncSpan(const char *name, qint64 start, int feedId, quintptr id)
+{
+  if (!enabled_ || (start < 0))
+    return;
+
+  Event event;
+  event.name = name;
+  event.start = start;
+  event.duration = timestamp() - start;
+  event.feedId = feedId;
+  event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  event.asyncId = id;
+  addEvent(event);
+}
+
+/** @brief Add sample of counter, e.g. length of queue
+ *----------------------------------------------------------------------------*/
+void Tracer::addCounter(const char *name, const char *valueName, qint64 value)
+{
+  if (!enabled_)
+    return;
+
+  QString json = QString("{\"name\":\"%1\",\"cat\":\"update\",\"ph\":\"C\",\"ts\":%2,"
+                         "\"pid\":%3,\"args\":{\"%4\":%5}}").
+      arg(QLatin1String(name)).arg(timestamp()).
+      arg(QCoreApplication::applicationPid()).
+      arg(QLatin1String(valueName)).arg(value);
+
+  QMutexLocker locker(&traceMutex);
+  if (!enabled_ || (traceEvents.count() >= TRACE_MAX_EVENTS))
+    return;
+  traceEvents.append(json.toUtf8());
+}
+
+void Tracer::addEvent(const Event &event)
+{
+  QString json;
+  if (event.asyncId) {
+    writeEvent(&json, event, "b", event.start);
+    json.append(",\n");
+    writeEvent(&json, event, "e", event.start + event.duration);
+  } else {
+    writeEvent(&json, event, "X", event.start);
+  }
+
+  QMutexLocker locker(&traceMutex);
+  if (!enabled_ || (traceEvents.count() >= TRACE_MAX_EVENTS))
+    return;
+  traceEvents.append(json.toUtf8());
+  if (!traceThreads.contains(event.threadId)) {
+    QString threadName = QThread::currentThread()->objectName();
+    if (threadName.isEmpty()) {
+      if (QThread::currentThread() == QCoreApplication::instance()->thread())
+        threadName = "main";
+      else
+        threadName = QString::number(event.threadId);
+    }
+    traceThreads.insert(event.threadId, threadName);
+  }
+}
+
+void Tracer::writeEvent(QString *json, const Event &event, const char *phase,
+                        qint64 timestamp)
+{
+  json->append(QString("{\"name\":\"%1\",\"cat\":\"update\",\"ph\":\"%2\",\"ts\":%3,"
+                       "\"pid\":%4,\"tid\":%5").
+               arg(QLatin1String(event.name)).arg(QLatin1String(phase)).
+               arg(timestamp).arg(QCoreApplication::applicationPid()).
+               arg(event.threadId));
+  if (qstrcmp(phase, "X") == 0)
+    json->append(QString(",\"dur\":%1").arg(event.duration));
+  if (event.asyncId)
+    json->append(QString(",\"id\":%1").arg(event.asyncId));
+  if (event.feedId >= 0)
+    json->append(QString(",\"args\":{\"feedId\":%1}").arg(event.feedId));
+  json->append("}");
+}
@@ -0,0 +1,89 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QList>
+#include <QString>
+
+/** @brief Timing of update stages written as Chrome trace event JSON
+ *
+ * Tracing is enabled with "traceOutput" setting. When it is disabled a span
+ * costs one flag check. Trace file can be opened in chrome://tracing or
+ * Perfetto UI
+ *----------------------------------------------------------------------------*/
+class Tracer
+{
+public:
+  static void start(const QString &fileName);
+  static void stop();
+  static bool isEnabled() { return enabled_; }
+
+  static qint64 timestamp();
+  static void addSpan(const char *name, qint64 start, int feedId = -1);
+  static void addAsyncSpan(const char *name, qint64 start, int feedId, quintptr id);
+  static void addCounter(const char *name, const char *valueName, qint64 value);
+
+private:
+  struct Event
+  {
+    const char *name;
+    qint64 start;
+    qint64 duration;
+    int feedId;
+    quintptr threadId;
+    quintptr asyncId;
+  };
+
+  static void addEvent(const Event &event);
+  static void writeEvent(QString *json, const Event &event, const char *phase,
+                         qint64 timestamp);
+
+  static bool enabled_;
+
+};
+
+/** @brief Span from construction to destruction or finish()
+ *----------------------------------------------------------------------------*/
+class TraceSpan
+{
+public:
+  explicit TraceSpan(const char *name, int feedId = -1)
+    : name_(name)
+    , feedId_(feedId)
+    , start_(Tracer::isEnabled() ? Tracer::timestamp() : -1)
+  {
+  }
+  ~TraceSpan() { finish(); }
+
+  void finish()
+  {
+    if (start_ >= 0) {
+      Tracer::addSpan(name_, start_, feedId_);
+      start_ = -1;
+    }
+  }
+
+private:
+  const char *name_;
+  int feedId_;
+  qint64 start_;
+
+};
+
+#endif // TRACER_H
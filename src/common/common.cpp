@@ -171,6 +171,17 @@ void Common::sleep(int ms)
 #endif
 }
 
+/** @brief Current UTC time in seconds since 1970-01-01T00:00:00
+ *---------------------------------------------------------------------------*/
+qint64 Common::currentSecsSinceEpoch()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,8,0)
+  return QDateTime::currentDateTimeUtc().toSecsSinceEpoch();
+#else
+  return QDateTime::currentDateTimeUtc().toTime_t();
+#endif
+}
+
 QString Common::operatingSystem()
 {
 #ifdef Q_OS_MAC
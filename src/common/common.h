@@ -61,6 +61,7 @@ namespace Common
   QByteArray readAllFileByteContents(const QString &filename);
 
   void sleep(int ms);
+  qint64 currentSecsSinceEpoch();
 
   QString operatingSystem();
   QString cpuArchitecture();
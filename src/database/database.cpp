@@ -20,13 +20,25 @@
 #include "common.h"
 #include "mainapplication.h"
 #include "mainwindow.h"
+#include "logging.h"
 #include "settings.h"
 #include "VersionNo.h"
 #include "sqlitedriver.h"
 
 #include <sqlite3.h>
 
-const int versionDB = 17;
+const int versionDB = 23;
+
+const QString kCountNewsQuery(
+    "SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0");
+const QString kCountUnreadNewsQuery(
+    "SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0");
+const QString kCountNewNewsQuery(
+    "SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0");
+const QString kCleanUpNewsQuery(
+    "DELETE FROM news WHERE feedId=='%1' AND deleted >= 2");
+const QString kStarredNewsFilter("feedId > 0 AND deleted = 0 AND starred = 1");
+const QString kDeletedNewsFilter("feedId > 0 AND deleted = 1");
 
 const QString kCreateFeedsTableQuery(
     "CREATE TABLE feeds("
@@ -122,7 +134,14 @@ const QString kCreateFeedsTableQuery(
     // Version 17
     "SingleClickAction integer default 0, " // ENewsClickAction
     "DoubleClickAction integer default 0, " // ENewsClickAction
-    "MiddleClickAction integer default 0 "  // ENewsClickAction
+    "MiddleClickAction integer default 0, " // ENewsClickAction
+    // Version 18
+    "etag varchar, "                        // ETag of last received feed data
+    "lastModified varchar, "                // Last-Modified of last received feed data
+    // Version 19
+    "nextUpdate integer, "                  // Time of next automatic update, UTC seconds
+    // Version 21
+    "contentDigest varchar "                // SHA-1 of last received feed data
     ")");
 
 const QString kCreateNewsTableQuery(
@@ -162,7 +181,11 @@ const QString kCreateNewsTableQuery(
     "contributor varchar, "                // contributors (tabs separated)
     "rights varchar, "                     // copyrights
     "deleteDate varchar, "                 // news delete timestamp
-    "feedParentId integer default 0 "      // parent feed id from feed table
+    "feedParentId integer default 0, "     // parent feed id from feed table
+    // Version 20
+    "titleHash integer, "                  // hash of lowercase title, see Database::titleHash()
+    // Version 22
+    "itemHash integer "                    // hash of item identity in feed data, see ParseWorker::itemHash()
     ")");
 
 const QString kCreateFiltersTable(
@@ -222,6 +245,48 @@ int Database::version()
   return versionDB;
 }
 
+/** @brief Hash of news title for indexed search of identical news
+ *
+ * Title is compared in lower case as LIKE does. Result mustn't depend on
+ * platform or Qt version because it is stored in database
+ *----------------------------------------------------------------------------*/
+qint64 Database::titleHash(const QString &title)
+{
+  return hash(title.toLower().toUtf8());
+}
+
+/** @brief First 8 bytes of MD5 as number, for compact hashes stored in base
+ *----------------------------------------------------------------------------*/
+qint64 Database::hash(const QByteArray &data)
+{
+  QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+  quint64 value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value = (value << 8) | static_cast<unsigned char>(hash.at(i));
+  }
+  return static_cast<qint64>(value);
+}
+
+/** @brief Add value to counter of feed in feeds_ex table
+ *----------------------------------------------------------------------------*/
+void Database::addFeedCounter(QSqlDatabase &db, int feedId,
+                              const QString &name, qint64 value)
+{
+  QSqlQuery q(db);
+  q.prepare("UPDATE feeds_ex SET value=CAST(value AS integer)+? WHERE feedId=? AND name=?");
+  q.addBindValue(value);
+  q.addBindValue(feedId);
+  q.addBindValue(name);
+  q.exec();
+  if (q.numRowsAffected() <= 0) {
+    q.prepare("INSERT INTO feeds_ex(feedId, name, value) VALUES (?, ?, ?)");
+    q.addBindValue(feedId);
+    q.addBindValue(name);
+    q.addBindValue(value);
+    q.exec();
+  }
+}
+
 void Database::initialization()
 {
   prepareDatabase();
@@ -325,6 +390,47 @@ void Database::prepareDatabase()
           q.exec("ALTER table feeds ADD COLUMN DoubleClickAction integer default 0");
           q.exec("ALTER table feeds ADD COLUMN MiddleClickAction integer default 0");
         }
+        if (dbVersion < 18) {
+          q.exec("ALTER TABLE feeds ADD COLUMN etag varchar");
+          q.exec("ALTER TABLE feeds ADD COLUMN lastModified varchar");
+        }
+        if (dbVersion < 19) {
+          q.exec("ALTER TABLE feeds ADD COLUMN nextUpdate integer");
+        }
+        if (dbVersion < 20) {
+          q.exec("ALTER TABLE news ADD COLUMN titleHash integer");
+          db.transaction();
+          QSqlQuery qUpdate(db);
+          qUpdate.prepare("UPDATE news SET titleHash=? WHERE id=?");
+          q.exec("SELECT id, title FROM news");
+          while (q.next()) {
+            qUpdate.addBindValue(titleHash(q.value(1).toString()));
+            qUpdate.addBindValue(q.value(0).toInt());
+            qUpdate.exec();
+          }
+          db.commit();
+          q.exec("CREATE INDEX titleHash ON news(titleHash)");
+        }
+        if (dbVersion < 21) {
+          q.exec("ALTER TABLE feeds ADD COLUMN contentDigest varchar");
+        }
+        if (dbVersion < 22) {
+          q.exec("ALTER TABLE news ADD COLUMN itemHash integer");
+        }
+        if (dbVersion < 23) {
+          q.exec("DROP INDEX IF EXISTS feedId");
+          createNewsIndexes(db);
+          q.exec("ANALYZE");
+        }
+        // Plans are checked when indexes are created and when application
+        // with its SQLite is upgraded
+        if ((dbVersion < 23) || (appVersion != STRPRODUCTVER)) {
+          if (!checkQueryPlans(db)) {
+            // Planner skips indexes with stale statistics
+            q.exec("ANALYZE");
+            checkQueryPlans(db);
+          }
+        }
 
         // Update appVersion anyway
         if (appVersion.isEmpty()) {
@@ -357,6 +463,64 @@ void Database::prepareDatabase()
   QSqlDatabase::removeDatabase("initialization");
 }
 
+/** @brief Indexes for counts of feeds, cleanup and news categories
+ *
+ * Index on feedId, deleted and read serves also queries on feedId only.
+ * Partial indexes hold only new, starred and deleted news
+ *----------------------------------------------------------------------------*/
+void Database::createNewsIndexes(QSqlDatabase &db)
+{
+  db.exec("CREATE INDEX feedId_deleted_read ON news(feedId, deleted, read)");
+  db.exec("CREATE INDEX newNews ON news(feedId, deleted, new) WHERE new = 1");
+  db.exec("CREATE INDEX starredNews ON news(feedId, deleted) WHERE starred = 1");
+  db.exec("CREATE INDEX deletedNews ON news(feedId) WHERE deleted = 1");
+}
+
+/** @brief Check that frequent news queries use their indexes
+ *
+ * Run after migration to new indexes, after upgrade of application and
+ * on request (--check-query-plans). Covers counts of all,
+ * unread and new news of feed, cleanup of deleted news and news of starred
+ * and deleted categories, built from the same constants as these queries.
+ * Other queries on news table aren't checked
+ * @return false if query plan of some query doesn't use expected index
+ *----------------------------------------------------------------------------*/
+bool Database::checkQueryPlans(QSqlDatabase &db)
+{
+  QList<QPair<QString, QString> > queries;
+  queries << qMakePair(kCountNewsQuery.arg(1), QString("feedId_deleted_read"))
+          << qMakePair(kCountUnreadNewsQuery.arg(1), QString("feedId_deleted_read"))
+          << qMakePair(kCountNewNewsQuery.arg(1), QString("newNews"))
+          << qMakePair(kCleanUpNewsQuery.arg(1), QString("feedId_deleted_read"))
+          << qMakePair("SELECT id FROM news WHERE " + kStarredNewsFilter,
+                       QString("starredNews"))
+          << qMakePair("SELECT id FROM news WHERE " + kDeletedNewsFilter,
+                       QString("deletedNews"));
+
+  int failedCount = 0;
+  QSqlQuery q(db);
+  for (int i = 0; i < queries.count(); ++i) {
+    const QString &query = queries.at(i).first;
+    const QString &index = queries.at(i).second;
+    QString plan;
+    q.exec(QString("EXPLAIN QUERY PLAN %1").arg(query));
+    while (q.next())
+      plan.append(q.value(q.record().count() - 1).toString()).append("; ");
+
+    if (!plan.contains(QString("INDEX %1").arg(index))) {
+      qWarning() << "Query doesn't use index" << index << ":"
+                 << query << "plan:" << plan;
+      failedCount++;
+    } else {
+      qCDebug(lcDatabase) << "Query plan:" << query << plan;
+    }
+  }
+
+  qWarning() << QString("Query plans: %1 of %2 queries use their indexes").
+                arg(queries.count() - failedCount).arg(queries.count());
+  return (failedCount == 0);
+}
+
 void Database::createTables(QSqlDatabase &db)
 {
   db.transaction();
@@ -364,8 +528,9 @@ void Database::createTables(QSqlDatabase &db)
   db.exec(kCreateFeedsTableQuery);
   db.exec(kAddColumnsFeedsTableQuery);
   db.exec(kCreateNewsTableQuery);
-  // Create index for feedId field
-  db.exec("CREATE INDEX feedId ON news(feedId)");
+  createNewsIndexes(db);
+  // Create index for search of identical news in other feeds
+  db.exec("CREATE INDEX titleHash ON news(titleHash)");
 
   // Create extra feeds table just in case
   db.exec("CREATE TABLE feeds_ex(id integer primary key, "
@@ -508,7 +673,7 @@ void Database::sqliteDBMemFile(QSqlDatabase &db, bool save)
           if (!mainApp->isNoDebugOutput()) {
             int remaining = sqlite3_backup_remaining(pBackup);
             int pagecount = sqlite3_backup_pagecount(pBackup);
-            qDebug() << rc << "backup" << pagecount << "remain" << remaining;
+            qCDebug(lcDatabase) << rc << "backup" << pagecount << "remain" << remaining;
           }
 
           if ((rc == SQLITE_OK) || (rc == SQLITE_BUSY) || (rc == SQLITE_LOCKED))
@@ -21,18 +21,34 @@
 #include <QtCore>
 #include <QtSql>
 
+// Frequent news queries on indexes of news table, %1 is feed id.
+// Their plans are checked by Database::checkQueryPlans()
+extern const QString kCountNewsQuery;
+extern const QString kCountUnreadNewsQuery;
+extern const QString kCountNewNewsQuery;
+extern const QString kCleanUpNewsQuery;
+// Conditions of news categories
+extern const QString kStarredNewsFilter;
+extern const QString kDeletedNewsFilter;
+
 class Database : public QObject
 {
   Q_OBJECT
 public:
   static int version();
+  static qint64 hash(const QByteArray &data);
+  static qint64 titleHash(const QString &title);
+  static void addFeedCounter(QSqlDatabase &db, int feedId,
+                             const QString &name, qint64 value);
   static void initialization();
   static QSqlDatabase connection(const QString &connectionName = QString());
   static void sqliteDBMemFile(QSqlDatabase &db, bool save = true);
   static void setVacuum();
+  static void setPragma(QSqlDatabase &db);
+  static bool checkQueryPlans(QSqlDatabase &db);
 
 private:
-  static void setPragma(QSqlDatabase &db);
+  static void createNewsIndexes(QSqlDatabase &db);
   static void createTables(QSqlDatabase &db);
   static void prepareDatabase();
   static void createLabels(QSqlDatabase &db);
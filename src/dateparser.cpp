@@ -0,0 +1,266 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "dateparser.h"
+
+static void skipSpaces(const QString &str, int *pos)
+{
+  while ((*pos < str.length()) && str.at(*pos).isSpace())
+    ++(*pos);
+}
+
+static bool readChar(const QString &str, int *pos, char c)
+{
+  if ((*pos < str.length()) && (str.at(*pos) == QLatin1Char(c))) {
+    ++(*pos);
+    return true;
+  }
+  return false;
+}
+
+/** @brief Read unsigned number of minDigits..maxDigits digits
+ * @return number or -1 if there are too few digits
+ *----------------------------------------------------------------------------*/
+static int readNumber(const QString &str, int *pos, int minDigits, int maxDigits,
+                      int *digits = 0)
+{
+  int value = 0;
+  int count = 0;
+  while ((*pos < str.length()) && (count < maxDigits) && str.at(*pos).isDigit()) {
+    value = value * 10 + str.at(*pos).digitValue();
+    ++(*pos);
+    ++count;
+  }
+  if (digits) *digits = count;
+  if (count < minDigits) return -1;
+  return value;
+}
+
+static QString readWord(const QString &str, int *pos)
+{
+  int start = *pos;
+  while ((*pos < str.length()) && str.at(*pos).isLetter())
+    ++(*pos);
+  return str.mid(start, *pos - start);
+}
+
+/** @brief Read HH:mm[:ss[.zzz]]
+ *----------------------------------------------------------------------------*/
+static bool readTime(const QString &str, int *pos, QTime *time)
+{
+  int p = *pos;
+  int hour = readNumber(str, &p, 1, 2);
+  if ((hour < 0) || !readChar(str, &p, ':'))
+    return false;
+  int minute = readNumber(str, &p, 2, 2);
+  if (minute < 0)
+    return false;
+  int second = 0;
+  int msec = 0;
+  if (readChar(str, &p, ':')) {
+    second = readNumber(str, &p, 2, 2);
+    if (second < 0)
+      return false;
+    if (second == 60)  // leap second
+      second = 59;
+    if (readChar(str, &p, '.') || readChar(str, &p, ',')) {
+      int digits;
+      msec = readNumber(str, &p, 1, 3, &digits);
+      if (msec < 0)
+        return false;
+      for (; digits < 3; ++digits)
+        msec *= 10;
+      while ((p < str.length()) && str.at(p).isDigit())
+        ++p;
+    }
+  }
+
+  *time = QTime(hour, minute, second, msec);
+  if (!time->isValid())
+    return false;
+  *pos = p;
+  return true;
+}
+
+/** @brief Read numeric or named time zone as offset from UTC in seconds
+ * @param anyName - take unknown zone names as UTC, otherwise they aren't read
+ * @return false if string has no zone
+ *----------------------------------------------------------------------------*/
+static bool readZone(const QString &str, int *pos, int *offset, bool anyName = true)
+{
+  skipSpaces(str, pos);
+  if (*pos >= str.length())
+    return false;
+
+  *offset = 0;
+  QChar sign = str.at(*pos);
+  if (sign.isLetter()) {
+    int start = *pos;
+    QString name = readWord(str, pos).toUpper();
+    if ((name == "Z") || (name == "GMT") || (name == "UT") || (name == "UTC")) {
+      // "GMT+03:00"
+      if ((*pos >= str.length()) ||
+          ((str.at(*pos) != QLatin1Char('+')) && (str.at(*pos) != QLatin1Char('-'))))
+        return true;
+      sign = str.at(*pos);
+    } else {
+      static const struct {
+        const char *name;
+        int hours;
+      } zones[] = {
+        { "EST", -5 }, { "EDT", -4 }, { "CST", -6 }, { "CDT", -5 },
+        { "MST", -7 }, { "MDT", -6 }, { "PST", -8 }, { "PDT", -7 },
+        { "AKST", -9 }, { "AKDT", -8 }, { "HST", -10 },
+        { "WET", 0 }, { "WEST", 1 }, { "BST", 1 }, { "CET", 1 }, { "CEST", 2 },
+        { "EET", 2 }, { "EEST", 3 }, { "MSK", 3 }, { "JST", 9 }, { "KST", 9 },
+        { "AEST", 10 }, { "AEDT", 11 }
+      };
+      for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); ++i) {
+        if (name == QLatin1String(zones[i].name)) {
+          *offset = zones[i].hours * 3600;
+          return true;
+        }
+      }
+      // Unknown zones and military letters are taken as UTC (RFC 5322)
+      if (!anyName) {
+        *pos = start;
+        return false;
+      }
+      return true;
+    }
+  }
+
+  if ((sign != QLatin1Char('+')) && (sign != QLatin1Char('-')))
+    return false;
+  ++(*pos);
+
+  int hours = readNumber(str, pos, 1, 2);
+  if (hours < 0)
+    return false;
+  int minutes = 0;
+  if (readChar(str, pos, ':') || ((*pos < str.length()) && str.at(*pos).isDigit())) {
+    minutes = readNumber(str, pos, 2, 2);
+    if (minutes < 0)
+      return false;
+  }
+  *offset = (hours * 3600 + minutes * 60) * ((sign == QLatin1Char('-')) ? -1 : 1);
+  return true;
+}
+
+static QDateTime toUtc(const QDate &date, const QTime &time, bool hasZone, int offset)
+{
+  if (!date.isValid() || !time.isValid())
+    return QDateTime();
+  if (!hasZone)
+    return QDateTime(date, time, Qt::LocalTime).toUTC();
+  return QDateTime(date, time, Qt::UTC).addSecs(-offset);
+}
+
+/** @brief Parse "yyyy-MM-dd[(T| )HH:mm[:ss[.zzz]]][zone]"
+ * @details Unknown zone or other text after date isn't taken as UTC,
+ *   date is invalid then
+ *----------------------------------------------------------------------------*/
+QDateTime DateParser::fromIso(const QString &dateString)
+{
+  int pos = 0;
+  skipSpaces(dateString, &pos);
+
+  int year = readNumber(dateString, &pos, 4, 4);
+  if ((year < 0) || !readChar(dateString, &pos, '-'))
+    return QDateTime();
+  int month = readNumber(dateString, &pos, 1, 2);
+  if ((month < 0) || !readChar(dateString, &pos, '-'))
+    return QDateTime();
+  int day = readNumber(dateString, &pos, 1, 2);
+  if (day < 0)
+    return QDateTime();
+
+  QTime time(0, 0);
+  if (readChar(dateString, &pos, 'T') || readChar(dateString, &pos, 't')) {
+    if (!readTime(dateString, &pos, &time))
+      return QDateTime();
+  } else {
+    int timePos = pos;
+    skipSpaces(dateString, &timePos);
+    if (readTime(dateString, &timePos, &time))
+      pos = timePos;
+  }
+
+  int offset = 0;
+  bool hasZone = readZone(dateString, &pos, &offset, false);
+  skipSpaces(dateString, &pos);
+  if (pos < dateString.length())
+    return QDateTime();
+  return toUtc(QDate(year, month, day), time, hasZone, offset);
+}
+
+/** @brief Parse "[ddd,] d MMM yy[yy] [HH:mm[:ss]] [zone]"
+ *----------------------------------------------------------------------------*/
+QDateTime DateParser::fromRfc822(const QString &dateString)
+{
+  static const char *months[] = {
+    "jan", "feb", "mar", "apr", "may", "jun",
+    "jul", "aug", "sep", "oct", "nov", "dec"
+  };
+
+  int pos = 0;
+  skipSpaces(dateString, &pos);
+
+  // day of week
+  if ((pos < dateString.length()) && dateString.at(pos).isLetter()) {
+    readWord(dateString, &pos);
+    skipSpaces(dateString, &pos);
+  }
+  if (readChar(dateString, &pos, ','))
+    skipSpaces(dateString, &pos);
+
+  int day = readNumber(dateString, &pos, 1, 2);
+  if (day < 0)
+    return QDateTime();
+  if (!readChar(dateString, &pos, '-'))
+    skipSpaces(dateString, &pos);
+
+  QString monthName = readWord(dateString, &pos).left(3).toLower();
+  int month = 0;
+  for (int i = 0; i < 12; ++i) {
+    if (monthName == QLatin1String(months[i])) {
+      month = i + 1;
+      break;
+    }
+  }
+  if (month == 0)
+    return QDateTime();
+  if (!readChar(dateString, &pos, '-'))
+    skipSpaces(dateString, &pos);
+
+  int digits;
+  int year = readNumber(dateString, &pos, 2, 4, &digits);
+  if (year < 0)
+    return QDateTime();
+  if (digits == 2)
+    year += (year > 70) ? 1900 : 2000;
+  else if (digits == 3)
+    year += 1900;
+
+  QTime time(0, 0);
+  skipSpaces(dateString, &pos);
+  readTime(dateString, &pos, &time);
+
+  int offset = 0;
+  bool hasZone = readZone(dateString, &pos, &offset);
+  return toUtc(QDate(year, month, day), time, hasZone, offset);
+}
@@ -0,0 +1,42 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef DATEPARSER_H
+#define DATEPARSER_H
+
+#include <QDateTime>
+#include <QString>
+
+/** @brief Parsing of feed date/time strings
+ *
+ * Hand-written scanners for RFC 822 (RSS) and RFC 3339/ISO 8601 (Atom)
+ * dates. Returned date/time is in UTC, invalid if string doesn't match.
+ * Date/time without zone is treated as local time
+ *----------------------------------------------------------------------------*/
+namespace DateParser
+{
+  enum Format {
+    IsoFormat,
+    RfcFormat,
+    LocaleFormat
+  };
+
+  QDateTime fromIso(const QString &dateString);
+  QDateTime fromRfc822(const QString &dateString);
+}
+
+#endif // DATEPARSER_H
@@ -16,9 +16,12 @@
 * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 * ============================================================ */
 #include "faviconobject.h"
+#include "contentdecoder.h"
+#include "retrypolicy.h"
 #include "VersionNo.h"
 #include "mainapplication.h"
 #include "globals.h"
+#include "logging.h"
 
 #include <QDebug>
 #include <QtSql>
@@ -33,19 +36,30 @@ FaviconObject::FaviconObject(QObject *parent)
 {
   setObjectName("faviconObject_");
 
-  timeout_ = new QTimer(this);
-  timeout_->setInterval(1000);
-  connect(timeout_, SIGNAL(timeout()), this, SLOT(slotRequestTimeout()));
+  timeoutQueue_ = new TimeoutQueue(this);
+  connect(timeoutQueue_, SIGNAL(timeout(QNetworkReply*)),
+          this, SLOT(slotRequestTimeout(QNetworkReply*)));
 
   getUrlTimer_ = new QTimer(this);
   getUrlTimer_->setSingleShot(true);
   getUrlTimer_->setInterval(20);
   connect(getUrlTimer_, SIGNAL(timeout()), this, SLOT(getQueuedUrl()));
 
+  clock_.start();
+  retryTimer_ = new QTimer(this);
+  retryTimer_->setSingleShot(true);
+  connect(retryTimer_, SIGNAL(timeout()), this, SLOT(slotRetry()));
+
   connect(this, SIGNAL(signalGet(QUrl,QString,int)),
           SLOT(slotGet(QUrl,QString,int)));
 }
 
+FaviconObject::~FaviconObject()
+{
+  foreach (const RequestState &state, requests_)
+    delete state.decoder;
+}
+
 void FaviconObject::disconnectObjects()
 {
   disconnect(this);
@@ -63,9 +77,6 @@ void FaviconObject::requestUrl(QString urlString, QString feedUrl)
             this, SLOT(finished(QNetworkReply*)));
   }
 
-  if (!timeout_->isActive())
-    timeout_->start();
-
   urlsQueue_.enqueue(urlString);
   feedsQueue_.enqueue(feedUrl);
 
@@ -77,7 +88,7 @@ void FaviconObject::requestUrl(QString urlString, QString feedUrl)
  *----------------------------------------------------------------------------*/
 void FaviconObject::getQueuedUrl()
 {
-  if (currentFeeds_.count() >= REPLY_MAX_COUNT) {
+  if (requests_.count() >= REPLY_MAX_COUNT) {
     getUrlTimer_->start();
     return;
   }
@@ -88,8 +99,8 @@ void FaviconObject::getQueuedUrl()
     QString feedUrl = feedsQueue_.head();
 
     if (hostList_.contains(QUrl(feedUrl).host())) {
-      foreach (QString url, currentFeeds_) {
-        if (QUrl(url).host() == QUrl(feedUrl).host()) {
+      foreach (const RequestState &state, requests_) {
+        if (QUrl(state.feedUrl).host() == QUrl(feedUrl).host()) {
           return;
         }
       }
@@ -112,33 +123,87 @@ void FaviconObject::getQueuedUrl()
  *----------------------------------------------------------------------------*/
 void FaviconObject::slotGet(const QUrl &getUrl, const QString &feedUrl, const int &count)
 {
-  if (count)
-    Common::sleep(30);
-
   QNetworkRequest request(getUrl);
   request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
-
-  currentUrls_.append(getUrl);
-  currentFeeds_.append(feedUrl);
-  currentCntRequests_.append(count);
-  currentTime_.append(REQUEST_TIMEOUT);
+  request.setRawHeader("Accept-Encoding", ContentDecoder::acceptEncoding());
 
   QNetworkReply *reply = networkManager_->get(request);
   reply->setProperty("feedReply", QVariant(true));
-  requestUrl_.append(reply->url());
-  networkReply_.append(reply);
+  connect(reply, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+
+  RequestState state;
+  state.url = getUrl;
+  state.feedUrl = feedUrl;
+  state.cntRequests = count;
+  state.decoder = NULL;
+  requests_.insert(reply, state);
+  timeoutQueue_->add(reply, REQUEST_TIMEOUT * 1000);
+}
+
+/** @brief Get decoder of reply body, create it on first chunk
+ *----------------------------------------------------------------------------*/
+ContentDecoder *FaviconObject::contentDecoder(RequestState &state, QNetworkReply *reply)
+{
+  if (!state.decoder)
+    state.decoder = new ContentDecoder(reply->rawHeader("Content-Encoding"));
+  return state.decoder;
+}
+
+/** @brief Decode reply body as it arrives
+ *----------------------------------------------------------------------------*/
+void FaviconObject::slotReadyRead()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+  QHash<QNetworkReply*, RequestState>::iterator it = requests_.find(reply);
+  if (it == requests_.end())
+    return;
+
+  contentDecoder(it.value(), reply)->write(reply->readAll());
+}
+
+/** @brief Repeat request after delay without blocking event loop
+ *----------------------------------------------------------------------------*/
+void FaviconObject::scheduleRetry(const QUrl &url, const QString &feedUrl,
+                                  int cntRequests, int delay)
+{
+  RetryRequest retry;
+  retry.url = url;
+  retry.feedUrl = feedUrl;
+  retry.cntRequests = cntRequests;
+
+  qint64 retryTime = clock_.elapsed() + delay;
+  retries_.insert(retryTime, retry);
+  if (retries_.begin().key() == retryTime)
+    retryTimer_->start(delay);
+}
+
+/** @brief Send repeats which delay is over
+ *----------------------------------------------------------------------------*/
+void FaviconObject::slotRetry()
+{
+  qint64 now = clock_.elapsed();
+  while (!retries_.isEmpty() && (retries_.begin().key() <= now)) {
+    RetryRequest retry = retries_.take(retries_.begin().key());
+    emit signalGet(retry.url, retry.feedUrl, retry.cntRequests);
+  }
+
+  if (!retries_.isEmpty())
+    retryTimer_->start(int(qMax(qint64(0), retries_.begin().key() - now)));
 }
 
 /** @brief Finish network request processing
  *----------------------------------------------------------------------------*/
 void FaviconObject::finished(QNetworkReply *reply)
 {
-  int currentReplyIndex = currentUrls_.indexOf(reply->url());
-  if (currentReplyIndex >= 0) {
-    currentTime_.removeAt(currentReplyIndex);
-    QUrl url = currentUrls_.takeAt(currentReplyIndex);
-    QString feedUrl = currentFeeds_.takeAt(currentReplyIndex);
-    int cntRequests = currentCntRequests_.takeAt(currentReplyIndex);
+  if (requests_.contains(reply)) {
+    RequestState state = requests_.take(reply);
+    timeoutQueue_->remove(reply);
+    QUrl url = state.url;
+    QString feedUrl = state.feedUrl;
+    int cntRequests = state.cntRequests;
+
+    ContentDecoder *decoder = contentDecoder(state, reply);
+    decoder->write(reply->readAll());
 
     if ((reply->error() == QNetworkReply::NoError) || (reply->error() == QNetworkReply::UnknownContentError)) {
       QUrl redirectionTarget = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
@@ -153,8 +218,12 @@ void FaviconObject::finished(QNetworkReply *reply)
           emit signalGet(redirectionTarget, feedUrl, cntRequests+2);
         }
       } else {
-        QByteArray data = reply->readAll();
-        if (!data.isNull()) {
+        qCDebug(lcNetwork) << "Favicon received:" << decoder->bytesReceived()
+                 << "decoded:" << decoder->bytesDecoded() << feedUrl;
+        QByteArray data;
+        if (!decoder->hasError())
+          data = decoder->data();
+        if (!data.isEmpty()) {
           if ((cntRequests == 0) || (cntRequests == 2)) {
             QString linkFavicon;
             QString str = QString::fromUtf8(data);
@@ -185,7 +254,7 @@ void FaviconObject::finished(QNetworkReply *reply)
                     urlFavicon.setScheme(url.scheme());
                   }
                   linkFavicon = urlFavicon.toString().simplified();
-                  qDebug() << "Favicon URL:" << linkFavicon;
+                  qCDebug(lcNetwork) << "Favicon URL:" << linkFavicon;
                   emit signalGet(linkFavicon, feedUrl, cntRequests+1);
                 }
               }
@@ -209,55 +278,43 @@ void FaviconObject::finished(QNetworkReply *reply)
         }
       }
     } else {
-      if (reply->errorString().contains("Service Temporarily Unavailable")) {
+      int retryAfter = RetryPolicy::retryAfterDelay(reply);
+      if ((retryAfter >= 0) ||
+          reply->errorString().contains("Service Temporarily Unavailable")) {
         if (!hostList_.contains(QUrl(feedUrl).host())) {
           hostList_.append(QUrl(feedUrl).host());
         }
       }
 
-      if ((cntRequests == 0) || (cntRequests == 1)) {
+      if (((cntRequests == 0) || (cntRequests == 1)) &&
+          (retryAfter <= RetryPolicy::maxDelay)) {
         QString link = QString("%1://%2").arg(url.scheme()).arg(url.host());
-        emit signalGet(link, feedUrl, 2);
-        qDebug() << "Request Url error: " << reply->url().toString() << reply->errorString();
+        scheduleRetry(link, feedUrl, 2,
+                      qMax(retryAfter, RetryPolicy::backoffDelay(1)));
+        qCDebug(lcNetwork) << "Request Url error: " << reply->url().toString() << reply->errorString();
       }
     }
+    delete decoder;
   } else {
     qCritical() << "Request Url error: " << reply->url().toString() << reply->errorString();
   }
 
-  int replyIndex = requestUrl_.indexOf(reply->url());
-  if (replyIndex >= 0) {
-    requestUrl_.removeAt(replyIndex);
-    networkReply_.removeAt(replyIndex);
-  }
   reply->abort();
   reply->deleteLater();
 }
 
-/** @brief Timeout to delete requests without answer from server
+/** @brief Delete request without answer from server
  *----------------------------------------------------------------------------*/
-void FaviconObject::slotRequestTimeout()
+void FaviconObject::slotRequestTimeout(QNetworkReply *reply)
 {
-  for (int i = currentTime_.count() - 1; i >= 0; i--) {
-    int time = currentTime_.at(i) - 1;
-    if (time <= 0) {
-      QUrl url = currentUrls_.takeAt(i);
-      QString feedUrl = currentFeeds_.takeAt(i);
-      int cntRequests = currentCntRequests_.takeAt(i);
-      currentTime_.removeAt(i);
-
-      int replyIndex = requestUrl_.indexOf(url);
-      if (replyIndex >= 0) {
-        requestUrl_.removeAt(replyIndex);
-        QNetworkReply *reply = networkReply_.takeAt(replyIndex);
-        reply->deleteLater();
-
-        if (cntRequests == 0) {
-          emit signalGet(url, feedUrl, 2);
-        }
-      }
-    } else {
-      currentTime_.replace(i, time);
-    }
+  if (!requests_.contains(reply))
+    return;
+
+  RequestState state = requests_.take(reply);
+  delete state.decoder;
+  reply->deleteLater();
+
+  if (state.cntRequests == 0) {
+    scheduleRetry(state.url, state.feedUrl, 2, RetryPolicy::backoffDelay(1));
   }
 }
@@ -19,12 +19,18 @@
 #define FAVICONOBJECT_H
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
 #include <QObject>
 #include <QQueue>
 #include <QNetworkReply>
 #include <QTimer>
 
 #include "networkmanager.h"
+#include "timeoutqueue.h"
+
+class ContentDecoder;
 
 class FaviconObject : public QObject
 {
@@ -32,6 +38,7 @@ class FaviconObject : public QObject
 
 public:
   explicit FaviconObject(QObject *parent = 0);
+  ~FaviconObject();
 
   void disconnectObjects();
 
@@ -47,22 +54,42 @@ signals:
 private slots:
   void getQueuedUrl();
   void finished(QNetworkReply *reply);
-  void slotRequestTimeout();
+  void slotRequestTimeout(QNetworkReply *reply);
+  void slotReadyRead();
+  void slotRetry();
 
 private:
+  /** State of request in flight, keyed by its network reply */
+  struct RequestState
+  {
+    QUrl url;
+    QString feedUrl;
+    int cntRequests;
+    ContentDecoder *decoder;
+  };
+
+  /** Repeat of request waiting for its backoff delay */
+  struct RetryRequest
+  {
+    QUrl url;
+    QString feedUrl;
+    int cntRequests;
+  };
+
+  ContentDecoder *contentDecoder(RequestState &state, QNetworkReply *reply);
+  void scheduleRetry(const QUrl &url, const QString &feedUrl, int cntRequests, int delay);
+
   NetworkManager *networkManager_;
 
   QQueue<QString> urlsQueue_;
   QQueue<QString> feedsQueue_;
 
-  QTimer *timeout_;
+  TimeoutQueue *timeoutQueue_;
   QTimer *getUrlTimer_;
-  QList<QUrl> currentUrls_;
-  QList<QString> currentFeeds_;
-  QList<int> currentCntRequests_;
-  QList<int> currentTime_;
-  QList<QUrl> requestUrl_;
-  QList<QNetworkReply*> networkReply_;
+  QTimer *retryTimer_;
+  QElapsedTimer clock_;
+  QHash<QNetworkReply*, RequestState> requests_;
+  QMultiMap<qint64, RetryRequest> retries_;
   QList<QString> hostList_;
 
 };
@@ -0,0 +1,371 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "feedcorpus.h"
+
+#include "mainapplication.h"
+#include "database.h"
+#include "dateparser.h"
+#include "parseobject.h"
+#include "sqlitedriver.h"
+#include "xmldecoder.h"
+#include "logging.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QXmlStreamReader>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+#define REPLAY_CONNECTION "replayConnection"
+
+/** @brief Directory of recorded feed data
+ *---------------------------------------------------------------------------*/
+QString FeedCorpus::corpusDir()
+{
+  return mainApp->dataDir() + "/corpus";
+}
+
+/** @brief Names of recorded files in order of recording
+ *---------------------------------------------------------------------------*/
+QStringList FeedCorpus::fileList()
+{
+  QDir dir(corpusDir());
+  return dir.entryList(QStringList("*.feed"), QDir::Files, QDir::Name);
+}
+
+/** @brief Save fetched data with reply headers into corpus
+ * @details Each entry is stored in own file: header lines, empty line, data
+ *---------------------------------------------------------------------------*/
+void FeedCorpus::record(const CorpusEntry &entry)
+{
+  QDir dir;
+  if (!dir.mkpath(corpusDir()))
+    return;
+
+  QString fileName = QString("%1/%2_%3.feed").arg(corpusDir()).
+      arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmsszzz")).
+      arg(entry.feedId);
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Can't record corpus file:" << fileName;
+    return;
+  }
+
+  QByteArray header;
+  header.append("Feed-Id: " + QByteArray::number(entry.feedId) + "\n");
+  header.append("Feed-Url: " + entry.feedUrl.toUtf8() + "\n");
+  header.append("Date: " + entry.dtReply.toString(Qt::ISODate).toUtf8() + "\n");
+  header.append("Charset: " + entry.codecName.toUtf8() + "\n");
+  header.append("ETag: " + entry.etag.toUtf8() + "\n");
+  header.append("Last-Modified: " + entry.lastModified.toUtf8() + "\n");
+  header.append("\n");
+  file.write(header);
+  file.write(entry.data);
+  file.close();
+}
+
+/** @brief Read recorded entry from corpus file
+ *---------------------------------------------------------------------------*/
+bool FeedCorpus::load(const QString &fileName, CorpusEntry *entry)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QByteArray data = file.readAll();
+  file.close();
+
+  int headerEnd = data.indexOf("\n\n");
+  if (headerEnd < 0)
+    return false;
+
+  entry->feedId = 0;
+  QList<QByteArray> lines = data.left(headerEnd).split('\n');
+  foreach (const QByteArray &line, lines) {
+    int sep = line.indexOf(": ");
+    if (sep < 0) continue;
+    QByteArray name = line.left(sep);
+    QString value = QString::fromUtf8(line.mid(sep + 2));
+    if (name == "Feed-Id") entry->feedId = value.toInt();
+    else if (name == "Feed-Url") entry->feedUrl = value;
+    else if (name == "Date") entry->dtReply = QDateTime::fromString(value, Qt::ISODate);
+    else if (name == "Charset") entry->codecName = value;
+    else if (name == "ETag") entry->etag = value;
+    else if (name == "Last-Modified") entry->lastModified = value;
+  }
+  entry->data = data.mid(headerEnd + 2);
+
+  return (entry->feedId > 0);
+}
+
+/** @brief Peak resident memory of process in bytes
+ *---------------------------------------------------------------------------*/
+qint64 FeedCorpus::peakMemoryUsage()
+{
+#if defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return pmc.PeakWorkingSetSize;
+  return 0;
+#elif defined(Q_OS_UNIX)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(Q_OS_MAC)
+  return usage.ru_maxrss;
+#else
+  return qint64(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+CorpusReplay::CorpusReplay(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("corpusReplay_");
+}
+
+/** @brief Replay recorded corpus through parser against scratch database
+ * @details Scratch database is copy of current database file, so news are
+ *   added to the same feeds without touching data of user.
+ *   Timings are written into corpus/replay.csv
+ *---------------------------------------------------------------------------*/
+void CorpusReplay::run()
+{
+  QDir dir(FeedCorpus::corpusDir());
+  QStringList fileList = FeedCorpus::fileList();
+  if (fileList.isEmpty()) {
+    qWarning() << "Corpus replay: no recorded data in" << dir.absolutePath();
+    emit finished();
+    return;
+  }
+
+  QString scratchFileName = dir.absoluteFilePath("replay.db");
+  QFile::remove(scratchFileName);
+  if (!QFile::copy(mainApp->dbFileName(), scratchFileName)) {
+    qWarning() << "Corpus replay: can't create scratch database" << scratchFileName;
+    emit finished();
+    return;
+  }
+
+  {
+    QSqlDatabase db = QSqlDatabase::addDatabase(new SQLiteDriver(), REPLAY_CONNECTION);
+    db.setDatabaseName(scratchFileName);
+    db.open();
+    Database::setPragma(db);
+
+    QFile reportFile(dir.absoluteFilePath("replay.csv"));
+    reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    QTextStream report(&reportFile);
+    report << "file,feedId,bytes,ms,peakMemoryKB\n";
+
+    ParseObject *parseObject = new ParseObject(0, db);
+
+    qWarning() << "Corpus replay: start," << fileList.count() << "files";
+    int feedsCount = 0;
+    qint64 totalBytes = 0;
+    QElapsedTimer totalTime;
+    totalTime.start();
+    foreach (const QString &fileName, fileList) {
+      CorpusEntry entry;
+      if (!FeedCorpus::load(dir.absoluteFilePath(fileName), &entry)) {
+        qWarning() << "Corpus replay: invalid file" << fileName;
+        continue;
+      }
+
+      QElapsedTimer feedTime;
+      feedTime.start();
+      QMetaObject::invokeMethod(parseObject, "slotParse", Qt::DirectConnection,
+                                Q_ARG(QByteArray, entry.data),
+                                Q_ARG(int, entry.feedId),
+                                Q_ARG(QDateTime, entry.dtReply),
+                                Q_ARG(QString, entry.codecName));
+      qint64 elapsed = feedTime.elapsed();
+
+      feedsCount++;
+      totalBytes += entry.data.size();
+      report << fileName << ',' << entry.feedId << ',' << entry.data.size() << ','
+             << elapsed << ',' << FeedCorpus::peakMemoryUsage() / 1024 << '\n';
+    }
+    qint64 totalElapsed = totalTime.elapsed();
+    report << "total,," << totalBytes << ',' << totalElapsed << ','
+           << FeedCorpus::peakMemoryUsage() / 1024 << '\n';
+    reportFile.close();
+
+    delete parseObject;
+    db.close();
+
+    qWarning() << QString("Corpus replay: %1 feeds, %2 bytes in %3 ms, peak memory %4 KB").
+                  arg(feedsCount).arg(totalBytes).arg(totalElapsed).
+                  arg(FeedCorpus::peakMemoryUsage() / 1024);
+  }
+  QSqlDatabase::removeDatabase(REPLAY_CONNECTION);
+  QFile::remove(scratchFileName);
+
+  emit finished();
+}
+
+//------------------------------------------------------------------------------
+DateBenchmark::DateBenchmark(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("dateBenchmark_");
+}
+
+/** @brief Time DateParser on dates of recorded corpus
+ * @details Dates are collected from date elements of all recorded feeds
+ *   first, so only parsing is timed. Each date is parsed as ISO 8601 and
+ *   then as RFC 822, like parser of feeds does without known format
+ *---------------------------------------------------------------------------*/
+void DateBenchmark::run()
+{
+  QDir dir(FeedCorpus::corpusDir());
+  QStringList fileList = FeedCorpus::fileList();
+  if (fileList.isEmpty()) {
+    qWarning() << "Date benchmark: no recorded data in" << dir.absolutePath();
+    emit finished();
+    return;
+  }
+
+  QStringList dateNames;
+  dateNames << "pubDate" << "pubdate" << "lastBuildDate" << "published"
+            << "updated" << "dc:date" << "modified" << "issued" << "created";
+
+  QStringList dateList;
+  foreach (const QString &fileName, fileList) {
+    CorpusEntry entry;
+    if (!FeedCorpus::load(dir.absoluteFilePath(fileName), &entry)) {
+      qWarning() << "Date benchmark: invalid file" << fileName;
+      continue;
+    }
+
+    QXmlStreamReader xml(XmlDecoder::decode(entry.data, entry.codecName));
+    xml.setNamespaceProcessing(false);
+    while (!xml.atEnd()) {
+      if ((xml.readNext() == QXmlStreamReader::StartElement) &&
+          dateNames.contains(xml.qualifiedName().toString())) {
+        QString date = xml.readElementText(QXmlStreamReader::SkipChildElements).simplified();
+        if (!date.isEmpty())
+          dateList.append(date);
+      }
+    }
+  }
+
+  int isoCount = 0;
+  int rfcCount = 0;
+  int failedCount = 0;
+  QElapsedTimer timer;
+  timer.start();
+  foreach (const QString &date, dateList) {
+    if (DateParser::fromIso(date).isValid()) {
+      isoCount++;
+    } else if (DateParser::fromRfc822(date).isValid()) {
+      rfcCount++;
+    } else {
+      failedCount++;
+      qCDebug(lcParse) << "Date benchmark: unparsed date" << date;
+    }
+  }
+  qint64 elapsed = timer.nsecsElapsed();
+
+  qWarning() << QString("Date benchmark: %1 dates from %2 files in %3 us, "
+                        "%4 dates/s, ISO %5, RFC 822 %6, unparsed %7").
+                arg(dateList.count()).arg(fileList.count()).arg(elapsed / 1000).
+                arg(elapsed ? qint64(dateList.count()) * 1000000000 / elapsed : 0).
+                arg(isoCount).arg(rfcCount).arg(failedCount);
+
+  emit finished();
+}
+
+//------------------------------------------------------------------------------
+DecoderBenchmark::DecoderBenchmark(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("decoderBenchmark_");
+}
+
+/** @brief Time XmlDecoder::decode on recorded corpus
+ * @details Data of each file is decoded with its recorded charset as
+ *   parser gets it. Timings are written into corpus/decoder.csv, files
+ *   that parser gives to reader undecoded are counted as streamed
+ *---------------------------------------------------------------------------*/
+void DecoderBenchmark::run()
+{
+  QDir dir(FeedCorpus::corpusDir());
+  QStringList fileList = FeedCorpus::fileList();
+  if (fileList.isEmpty()) {
+    qWarning() << "Decoder benchmark: no recorded data in" << dir.absolutePath();
+    emit finished();
+    return;
+  }
+
+  QFile reportFile(dir.absoluteFilePath("decoder.csv"));
+  reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+  QTextStream report(&reportFile);
+  report << "file,bytes,codec,streamed,us\n";
+
+  int filesCount = 0;
+  int streamedCount = 0;
+  qint64 totalBytes = 0;
+  qint64 totalElapsed = 0;
+  foreach (const QString &fileName, fileList) {
+    CorpusEntry entry;
+    if (!FeedCorpus::load(dir.absoluteFilePath(fileName), &entry)) {
+      qWarning() << "Decoder benchmark: invalid file" << fileName;
+      continue;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString text = XmlDecoder::decode(entry.data, entry.codecName);
+    qint64 elapsed = timer.nsecsElapsed();
+    text.clear();
+
+    QTextCodec *codec = XmlDecoder::codecForXml(entry.data, entry.codecName);
+    bool streamed = XmlDecoder::isReaderCodec(entry.data, entry.codecName);
+    filesCount++;
+    if (streamed) streamedCount++;
+    totalBytes += entry.data.size();
+    totalElapsed += elapsed;
+    report << fileName << ',' << entry.data.size() << ','
+           << (codec ? QString(codec->name()) : QString("-")) << ','
+           << (streamed ? 1 : 0) << ',' << elapsed / 1000 << '\n';
+  }
+  report << "total," << totalBytes << ",," << streamedCount << ','
+         << totalElapsed / 1000 << '\n';
+  reportFile.close();
+
+  qWarning() << QString("Decoder benchmark: %1 files, %2 bytes in %3 us, "
+                        "%4 KB/s, %5 files streamed").
+                arg(filesCount).arg(totalBytes).arg(totalElapsed / 1000).
+                arg(totalElapsed ? totalBytes * 1000000000 / totalElapsed / 1024 : 0).
+                arg(streamedCount);
+
+  emit finished();
+}
@@ -0,0 +1,88 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef FEEDCORPUS_H
+#define FEEDCORPUS_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QStringList>
+
+struct CorpusEntry {
+  int feedId;
+  QString feedUrl;
+  QDateTime dtReply;
+  QString codecName;
+  QString etag;
+  QString lastModified;
+  QByteArray data;
+};
+
+/** @brief Archive of fetched feed data for replaying through parser
+ *---------------------------------------------------------------------------*/
+namespace FeedCorpus
+{
+  QString corpusDir();
+  QStringList fileList();
+  void record(const CorpusEntry &entry);
+  bool load(const QString &fileName, CorpusEntry *entry);
+  qint64 peakMemoryUsage();
+}
+
+class CorpusReplay : public QObject
+{
+  Q_OBJECT
+public:
+  explicit CorpusReplay(QObject *parent = 0);
+
+public slots:
+  void run();
+
+signals:
+  void finished();
+
+};
+
+class DateBenchmark : public QObject
+{
+  Q_OBJECT
+public:
+  explicit DateBenchmark(QObject *parent = 0);
+
+public slots:
+  void run();
+
+signals:
+  void finished();
+
+};
+
+class DecoderBenchmark : public QObject
+{
+  Q_OBJECT
+public:
+  explicit DecoderBenchmark(QObject *parent = 0);
+
+public slots:
+  void run();
+
+signals:
+  void finished();
+
+};
+
+#endif // FEEDCORPUS_H
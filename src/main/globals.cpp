@@ -28,6 +28,7 @@
 #include <QDir>
 #include <QStringBuilder>
 
+#include "logging.h"
 #include "settings.h"
 
 Globals globals;
@@ -95,6 +96,7 @@ void Globals::init()
   Settings settings;
   settings.beginGroup("Settings");
   noDebugOutput_ = settings.value("noDebugOutput", true).toBool();
+  Logging::setRules(!noDebugOutput_, settings.value("logRules").toString());
   userAgent_ = settings.value("userAgent", "Mozilla/5.0 (Windows NT 6.1) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/77.0.3865.120 Safari/537.36").toString();
 
   isInit_ = true;
@@ -43,8 +43,10 @@ int main(int argc, char **argv)
 
   MainApplication app(argc, argv);
 
-  if (app.isClosing())
-    return 0;
+  int result = 0;
+  if (!app.isClosing())
+    result = app.exec();
 
-  return app.exec();
+  LogFile::stop();
+  return result;
 }
@@ -0,0 +1,144 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "contentdecoder.h"
+
+#include <QDebug>
+#if defined(Q_OS_WIN) || defined(Q_OS_OS2) || defined(Q_OS_MAC)
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#define INFLATE_CHUNK_SIZE 16384
+
+ContentDecoder::ContentDecoder(const QByteArray &contentEncoding)
+  : stream_(NULL)
+  , compressed_(false)
+  , rawDeflate_(false)
+  , finished_(false)
+  , error_(false)
+  , bytesReceived_(0)
+{
+  QByteArray encoding = contentEncoding.trimmed().toLower();
+  if ((encoding == "gzip") || (encoding == "x-gzip") || (encoding == "deflate")) {
+    compressed_ = true;
+    if (!initStream(false))
+      error_ = true;
+  } else if (!encoding.isEmpty() && (encoding != "identity")) {
+    qWarning() << "Unsupported content encoding:" << contentEncoding;
+  }
+}
+
+ContentDecoder::~ContentDecoder()
+{
+  endStream();
+}
+
+/** @brief Value of Accept-Encoding header for supported encodings
+ *----------------------------------------------------------------------------*/
+QByteArray ContentDecoder::acceptEncoding()
+{
+  return QByteArray("gzip, deflate");
+}
+
+/** @brief Decode next chunk of the body
+ * @return false on corrupted data
+ *----------------------------------------------------------------------------*/
+bool ContentDecoder::write(const QByteArray &chunk)
+{
+  if (error_)
+    return false;
+  if (chunk.isEmpty())
+    return true;
+
+  bytesReceived_ += chunk.size();
+
+  if (!compressed_) {
+    data_.append(chunk);
+    return true;
+  }
+  // Trailing garbage after the end of compressed stream is ignored
+  if (finished_)
+    return true;
+
+  char buffer[INFLATE_CHUNK_SIZE];
+  stream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.constData()));
+  stream_->avail_in = chunk.size();
+
+  while (stream_->avail_in > 0) {
+    stream_->next_out = reinterpret_cast<Bytef*>(buffer);
+    stream_->avail_out = INFLATE_CHUNK_SIZE;
+
+    int ret = inflate(stream_, Z_NO_FLUSH);
+    // Some servers send "deflate" without zlib header
+    if ((ret == Z_DATA_ERROR) && !rawDeflate_ && (stream_->total_out == 0)) {
+      endStream();
+      if (!initStream(true)) {
+        error_ = true;
+        return false;
+      }
+      stream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.constData()));
+      stream_->avail_in = chunk.size();
+      continue;
+    }
+    if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) {
+      qWarning() << "Content decoding error:" << ret;
+      error_ = true;
+      return false;
+    }
+
+    data_.append(buffer, INFLATE_CHUNK_SIZE - stream_->avail_out);
+
+    if (ret == Z_STREAM_END) {
+      finished_ = true;
+      break;
+    }
+    if ((ret == Z_BUF_ERROR) && (stream_->avail_out != 0))
+      break;
+  }
+  return true;
+}
+
+bool ContentDecoder::initStream(bool rawDeflate)
+{
+  stream_ = new z_stream;
+  stream_->zalloc = Z_NULL;
+  stream_->zfree = Z_NULL;
+  stream_->opaque = Z_NULL;
+  stream_->next_in = Z_NULL;
+  stream_->avail_in = 0;
+
+  rawDeflate_ = rawDeflate;
+  // 15 + 32: detect zlib or gzip header automatically, -15: raw deflate
+  int ret = inflateInit2(stream_, rawDeflate ? -MAX_WBITS : MAX_WBITS + 32);
+  if (ret != Z_OK) {
+    delete stream_;
+    stream_ = NULL;
+    return false;
+  }
+  return true;
+}
+
+void ContentDecoder::endStream()
+{
+  if (stream_) {
+    inflateEnd(stream_);
+    delete stream_;
+    stream_ = NULL;
+  }
+}
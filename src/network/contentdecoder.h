@@ -0,0 +1,59 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef CONTENTDECODER_H
+#define CONTENTDECODER_H
+
+#include <QByteArray>
+
+struct z_stream_s;
+
+/** @brief Incremental decoder of HTTP Content-Encoding (gzip, deflate)
+ *
+ * Chunks are inflated as they arrive from the network reply, so the
+ * compressed body is never kept in memory as a whole
+ *----------------------------------------------------------------------------*/
+class ContentDecoder
+{
+public:
+  explicit ContentDecoder(const QByteArray &contentEncoding = QByteArray());
+  ~ContentDecoder();
+
+  static QByteArray acceptEncoding();
+
+  bool write(const QByteArray &chunk);
+  QByteArray data() const { return data_; }
+  bool hasError() const { return error_; }
+
+  qint64 bytesReceived() const { return bytesReceived_; }
+  qint64 bytesDecoded() const { return data_.size(); }
+
+private:
+  bool initStream(bool rawDeflate);
+  void endStream();
+
+  z_stream_s *stream_;
+  bool compressed_;
+  bool rawDeflate_;
+  bool finished_;
+  bool error_;
+  qint64 bytesReceived_;
+  QByteArray data_;
+
+};
+
+#endif // CONTENTDECODER_H
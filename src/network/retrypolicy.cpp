@@ -0,0 +1,77 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "retrypolicy.h"
+
+#include <QDateTime>
+#include <QLocale>
+#if QT_VERSION >= 0x050A00
+#include <QRandomGenerator>
+#endif
+
+#define BACKOFF_BASE_DELAY 1000
+#define BACKOFF_MAX_DELAY 60000
+
+/** @brief Exponential backoff with jitter
+ * @param attempt - number of repeat starting from 1
+ * @return delay in ms, randomized between half and full backoff
+ *----------------------------------------------------------------------------*/
+int RetryPolicy::backoffDelay(int attempt)
+{
+  int delay = BACKOFF_BASE_DELAY;
+  for (int i = 1; (i < attempt) && (delay < BACKOFF_MAX_DELAY); ++i)
+    delay *= 2;
+  delay = qMin(delay, BACKOFF_MAX_DELAY);
+
+#if QT_VERSION >= 0x050A00
+  int jitter = QRandomGenerator::global()->bounded(delay / 2 + 1);
+#else
+  int jitter = qrand() % (delay / 2 + 1);
+#endif
+  return delay / 2 + jitter;
+}
+
+/** @brief Delay requested by server in Retry-After header
+ *
+ * Only replies with status 429 Too Many Requests and 503 Service Unavailable
+ * are considered. Header value is either seconds or HTTP-date.
+ * @return delay in ms, -1 if server did not ask to slow down
+ *----------------------------------------------------------------------------*/
+int RetryPolicy::retryAfterDelay(QNetworkReply *reply)
+{
+  int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if ((status != 429) && (status != 503))
+    return -1;
+
+  QByteArray value = reply->rawHeader("Retry-After").trimmed();
+  if (value.isEmpty())
+    return 0;
+
+  bool ok;
+  qint64 seconds = value.toLongLong(&ok);
+  if (!ok) {
+    // HTTP-date: Wed, 21 Oct 2015 07:28:00 GMT
+    QDateTime date = QLocale::c().toDateTime(QString::fromLatin1(value.left(25)),
+                                             "ddd, dd MMM yyyy hh:mm:ss");
+    if (!date.isValid())
+      return 0;
+    date.setTimeSpec(Qt::UTC);
+    seconds = QDateTime::currentDateTimeUtc().secsTo(date);
+  }
+
+  return int(qBound(qint64(0), seconds * 1000, qint64(maxDelay) + 1));
+}
@@ -0,0 +1,32 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QNetworkReply>
+
+namespace RetryPolicy
+{
+  // Upper bound of any delay before repeat, ms
+  static const int maxDelay = 5 * 60 * 1000;
+
+  int backoffDelay(int attempt);
+  int retryAfterDelay(QNetworkReply *reply);
+}
+
+#endif // RETRYPOLICY_H
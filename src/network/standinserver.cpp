@@ -0,0 +1,217 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "standinserver.h"
+
+#include "settings.h"
+
+#include <QDebug>
+#include <QDir>
+
+#define SEND_INTERVAL 50
+
+StandInServer::StandInServer(QObject *parent)
+  : QTcpServer(parent)
+  , requestsCount_(0)
+  , bytesSent_(0)
+{
+  setObjectName("standInServer_");
+
+  Settings settings;
+  settings.beginGroup("Benchmark");
+  latency_ = settings.value("latency", 50).toInt();
+  bandwidth_ = settings.value("bandwidth", 0).toInt();
+  errorRate_ = settings.value("errorRate", 0).toInt();
+  redirectRate_ = settings.value("redirectRate", 0).toInt();
+  notModified_ = settings.value("notModified", true).toBool();
+  settings.endGroup();
+
+  clock_.start();
+
+  sendTimer_ = new QTimer(this);
+  sendTimer_->setInterval(SEND_INTERVAL);
+  connect(sendTimer_, SIGNAL(timeout()), this, SLOT(slotSendData()));
+
+  connect(this, SIGNAL(newConnection()), SLOT(slotNewConnection()));
+}
+
+/** @brief Load latest recorded data of each feed and start listening
+ *----------------------------------------------------------------------------*/
+bool StandInServer::start()
+{
+  QDir dir(FeedCorpus::corpusDir());
+  QStringList fileList = dir.entryList(QStringList("*.feed"), QDir::Files, QDir::Name);
+  foreach (const QString &fileName, fileList) {
+    CorpusEntry entry;
+    if (FeedCorpus::load(dir.absoluteFilePath(fileName), &entry))
+      feeds_.insert(entry.feedId, entry);
+  }
+  if (feeds_.isEmpty()) {
+    qWarning() << "Stand-in server: no recorded data in" << dir.absolutePath();
+    return false;
+  }
+
+  if (!listen(QHostAddress::LocalHost)) {
+    qWarning() << "Stand-in server:" << errorString();
+    return false;
+  }
+  baseUrl_ = QString("http://127.0.0.1:%1").arg(serverPort());
+  qWarning() << "Stand-in server: serving" << feeds_.count() << "feeds at" << baseUrl_;
+  return true;
+}
+
+/** @brief Stop listening and close connections
+ * @details Called in thread of server, socket notifiers belong to it
+ *----------------------------------------------------------------------------*/
+void StandInServer::stop()
+{
+  sendTimer_->stop();
+  close();
+  requests_.clear();
+  replies_.clear();
+  foreach (QTcpSocket *socket, findChildren<QTcpSocket*>()) {
+    socket->disconnect(this);
+    socket->abort();
+    delete socket;
+  }
+}
+
+void StandInServer::slotNewConnection()
+{
+  while (hasPendingConnections()) {
+    QTcpSocket *socket = nextPendingConnection();
+    connect(socket, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(slotDisconnected()));
+  }
+}
+
+void StandInServer::slotReadyRead()
+{
+  QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+  if (!socket) return;
+
+  QByteArray &request = requests_[socket];
+  request.append(socket->readAll());
+  if (!request.contains("\r\n\r\n"))
+    return;
+
+  requestsCount_++;
+  PendingReply pending;
+  pending.data = reply(request);
+  pending.readyTime = clock_.elapsed() + latency_;
+  request.clear();
+  replies_.insert(socket, pending);
+
+  if (!sendTimer_->isActive())
+    sendTimer_->start();
+}
+
+void StandInServer::slotDisconnected()
+{
+  QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+  if (!socket) return;
+
+  requests_.remove(socket);
+  replies_.remove(socket);
+  socket->deleteLater();
+}
+
+/** @brief Write replies which passed latency, limited by bandwidth
+ *----------------------------------------------------------------------------*/
+void StandInServer::slotSendData()
+{
+  qint64 now = clock_.elapsed();
+  int chunkSize = bandwidth_ * SEND_INTERVAL / 1000;
+
+  QHash<QTcpSocket*, PendingReply>::iterator it = replies_.begin();
+  while (it != replies_.end()) {
+    if (it->readyTime > now) {
+      ++it;
+      continue;
+    }
+
+    QByteArray chunk = (chunkSize > 0) ? it->data.left(chunkSize) : it->data;
+    it.key()->write(chunk);
+    bytesSent_ += chunk.size();
+    it->data.remove(0, chunk.size());
+    if (it->data.isEmpty()) {
+      it.key()->disconnectFromHost();
+      it = replies_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (replies_.isEmpty())
+    sendTimer_->stop();
+}
+
+/** @brief Make reply for request: error, redirect, 304 or recorded data
+ *----------------------------------------------------------------------------*/
+QByteArray StandInServer::reply(const QByteArray &request)
+{
+  QList<QByteArray> lines = request.split('\n');
+  QByteArray path = lines.first().split(' ').value(1);
+  QByteArray ifNoneMatch;
+  foreach (const QByteArray &line, lines) {
+    if (line.toLower().startsWith("if-none-match:"))
+      ifNoneMatch = line.mid(14).trimmed();
+  }
+
+  bool redirected = path.startsWith("/r/");
+  if (redirected) path.remove(0, 2);
+  if (!path.startsWith("/feed/"))
+    return statusReply("404 Not Found");
+  int feedId = path.mid(6).toInt();
+  if (!feeds_.contains(feedId))
+    return statusReply("404 Not Found");
+
+  if ((errorRate_ > 0) && (qrand() % 100 < errorRate_))
+    return statusReply("500 Internal Server Error");
+  if (!redirected && (redirectRate_ > 0) && (qrand() % 100 < redirectRate_)) {
+    return statusReply("302 Found", QString("Location: %1/r/feed/%2\r\n").
+                       arg(baseUrl()).arg(feedId).toLatin1());
+  }
+
+  const CorpusEntry &entry = feeds_[feedId];
+  QByteArray headers;
+  if (!entry.etag.isEmpty()) {
+    if (notModified_ && (ifNoneMatch == entry.etag.toLatin1()))
+      return statusReply("304 Not Modified");
+    headers.append("ETag: " + entry.etag.toLatin1() + "\r\n");
+  }
+  if (!entry.lastModified.isEmpty())
+    headers.append("Last-Modified: " + entry.lastModified.toLatin1() + "\r\n");
+  headers.append("Content-Type: application/xml");
+  if (!entry.codecName.isEmpty())
+    headers.append("; charset=" + entry.codecName.toLatin1());
+  headers.append("\r\n");
+
+  return statusReply("200 OK", headers, entry.data);
+}
+
+QByteArray StandInServer::statusReply(const QByteArray &status,
+                                      const QByteArray &headers,
+                                      const QByteArray &body)
+{
+  QByteArray data = "HTTP/1.1 " + status + "\r\n";
+  data.append("Connection: close\r\n");
+  data.append(headers);
+  data.append("Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n");
+  data.append(body);
+  return data;
+}
@@ -0,0 +1,82 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef STANDINSERVER_H
+#define STANDINSERVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "feedcorpus.h"
+
+/** @brief Local HTTP server answering feed requests from recorded corpus
+ *
+ * Feeds are served as /feed/<feedId>. Latency, bandwidth, error and
+ * redirect rates and 304 behaviour are taken from "Benchmark" settings
+ *----------------------------------------------------------------------------*/
+class StandInServer : public QTcpServer
+{
+  Q_OBJECT
+public:
+  explicit StandInServer(QObject *parent = 0);
+
+  Q_INVOKABLE bool start();
+  Q_INVOKABLE void stop();
+  QString baseUrl() const { return baseUrl_; }
+  int requestsCount() const { return requestsCount_; }
+  qint64 bytesSent() const { return bytesSent_; }
+
+private slots:
+  void slotNewConnection();
+  void slotReadyRead();
+  void slotDisconnected();
+  void slotSendData();
+
+private:
+  /** Response waiting for its latency and bandwidth budget */
+  struct PendingReply
+  {
+    QByteArray data;
+    qint64 readyTime;
+  };
+
+  QByteArray reply(const QByteArray &request);
+  QByteArray statusReply(const QByteArray &status,
+                         const QByteArray &headers = QByteArray(),
+                         const QByteArray &body = QByteArray());
+
+  QHash<int, CorpusEntry> feeds_;
+  QHash<QTcpSocket*, QByteArray> requests_;
+  QHash<QTcpSocket*, PendingReply> replies_;
+  QElapsedTimer clock_;
+  QTimer *sendTimer_;
+  QString baseUrl_;
+
+  int latency_;
+  int bandwidth_;
+  int errorRate_;
+  int redirectRate_;
+  bool notModified_;
+  int requestsCount_;
+  qint64 bytesSent_;
+
+};
+
+#endif // STANDINSERVER_H
@@ -0,0 +1,89 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "timeoutqueue.h"
+
+TimeoutQueue::TimeoutQueue(QObject *parent)
+  : QObject(parent)
+{
+  clock_.start();
+
+  timer_ = new QTimer(this);
+  timer_->setSingleShot(true);
+#if QT_VERSION >= 0x050000
+  timer_->setTimerType(Qt::PreciseTimer);
+#endif
+  connect(timer_, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+}
+
+/** @brief Add deadline for reply
+ * @param msec - time from now in milliseconds
+ *----------------------------------------------------------------------------*/
+void TimeoutQueue::add(QNetworkReply *reply, int msec)
+{
+  remove(reply);
+
+  qint64 deadline = clock_.elapsed() + msec;
+  deadlines_.insert(deadline, reply);
+  replyDeadlines_.insert(reply, deadline);
+
+  if (deadlines_.begin().value() == reply)
+    restartTimer();
+}
+
+void TimeoutQueue::remove(QNetworkReply *reply)
+{
+  QHash<QNetworkReply*, qint64>::iterator it = replyDeadlines_.find(reply);
+  if (it == replyDeadlines_.end())
+    return;
+
+  deadlines_.remove(it.value(), reply);
+  replyDeadlines_.erase(it);
+  if (deadlines_.isEmpty())
+    timer_->stop();
+}
+
+/** @brief Emit timeout for all replies with expired deadline
+ *----------------------------------------------------------------------------*/
+void TimeoutQueue::slotTimeout()
+{
+  qint64 now = clock_.elapsed();
+  QList<QNetworkReply*> expiredReplies;
+  while (!deadlines_.isEmpty() && (deadlines_.begin().key() <= now)) {
+    QMultiMap<qint64, QNetworkReply*>::iterator it = deadlines_.begin();
+    expiredReplies.append(it.value());
+    replyDeadlines_.remove(it.value());
+    deadlines_.erase(it);
+  }
+
+  foreach (QNetworkReply *reply, expiredReplies) {
+    emit timeout(reply);
+  }
+
+  restartTimer();
+}
+
+void TimeoutQueue::restartTimer()
+{
+  if (deadlines_.isEmpty()) {
+    timer_->stop();
+    return;
+  }
+
+  qint64 delay = deadlines_.begin().key() - clock_.elapsed();
+  timer_->start(int(qMax(qint64(0), delay)));
+}
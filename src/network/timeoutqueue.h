@@ -0,0 +1,58 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef TIMEOUTQUEUE_H
+#define TIMEOUTQUEUE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QNetworkReply>
+#include <QTimer>
+
+/** @brief Deadlines of network replies ordered by time
+ *
+ * Single timer is armed for the nearest deadline only, so there is no
+ * work while idle and no per-request countdown
+ *----------------------------------------------------------------------------*/
+class TimeoutQueue : public QObject
+{
+  Q_OBJECT
+public:
+  explicit TimeoutQueue(QObject *parent = 0);
+
+  void add(QNetworkReply *reply, int msec);
+  void remove(QNetworkReply *reply);
+  bool isEmpty() const { return deadlines_.isEmpty(); }
+
+signals:
+  void timeout(QNetworkReply *reply);
+
+private slots:
+  void slotTimeout();
+
+private:
+  void restartTimer();
+
+  QElapsedTimer clock_;
+  QTimer *timer_;
+  QMultiMap<qint64, QNetworkReply*> deadlines_;
+  QHash<QNetworkReply*, qint64> replyDeadlines_;
+
+};
+
+#endif // TIMEOUTQUEUE_H
@@ -476,7 +476,7 @@ void OptionsDialog::createNetworkConnectionsWidget()
   timeoutRequest_ = new QSpinBox();
   timeoutRequest_->setRange(0, 300);
   numberRequests_ = new QSpinBox();
-  numberRequests_->setRange(1, 10);
+  numberRequests_->setRange(1, 50);
   numberRepeats_ = new QSpinBox();
   numberRepeats_->setRange(1, 10);
 
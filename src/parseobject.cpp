@@ -21,99 +21,413 @@
 #include "database.h"
 #include "VersionNo.h"
 #include "common.h"
+#include "settings.h"
+#include "tracer.h"
+#include "logging.h"
 
 #include <QDebug>
 #include <QDesktopServices>
-#include <QTextDocumentFragment>
+#include <QTemporaryFile>
 #if defined(Q_OS_WIN)
 #include <windows.h>
 #endif
-#include <qzregexp.h>
 
-ParseObject::ParseObject(QObject *parent)
+#define NEWS_COLUMNS 21
+#define WORKER_MAX_JOBS 2
+
+ParseObject::ParseObject(QObject *parent, const QSqlDatabase &db)
   : QObject(parent)
+  , insertedNewsCount_(0)
+  , insertNewsTime_(0)
+  , totalInsertedNewsCount_(0)
+  , totalInsertNewsTime_(0)
+  , totalItemsCount_(0)
+  , totalUnchangedItems_(0)
 {
   setObjectName("parseObject_");
 
-  db_ = Database::connection("secondConnection");
-
-  parseTimer_ = new QTimer(this);
-  parseTimer_->setSingleShot(true);
-  parseTimer_->setInterval(10);
-  connect(parseTimer_, SIGNAL(timeout()), this, SLOT(getQueuedXml()),
-          Qt::QueuedConnection);
-
-  connect(this, SIGNAL(signalReadyParse(QByteArray,int,QDateTime,QString)),
-          SLOT(slotParse(QByteArray,int,QDateTime,QString)));
+  if (db.isValid())
+    db_ = db;
+  else
+    db_ = Database::connection("secondConnection");
+
+  // Parse in thread of parse object writes each batch at once
+  localWorker_ = new ParseWorker(this);
+  connect(localWorker_, SIGNAL(parsed()), this, SLOT(slotParsed()),
+          Qt::DirectConnection);
+  writingWorker_ = 0;
+  nextWorker_ = 0;
+  writeStarted_ = false;
+  writtenItems_ = 0;
+
+  Settings settings;
+  maxQueueBytes_ = settings.value("Settings/parseQueueMaxBytes", 32*1024*1024).toLongLong();
+  spillQueue_ = settings.value("Settings/parseQueueSpill", true).toBool();
+  queueBytes_ = 0;
+  queueFull_ = false;
+  dispatchPending_ = false;
 }
 
 ParseObject::~ParseObject()
 {
-
+  foreach (const QueuedXml &queuedXml, xmlQueue_) {
+    if (!queuedXml.spillFile.isEmpty())
+      QFile::remove(queuedXml.spillFile);
+  }
 }
 
 void ParseObject::disconnectObjects()
 {
   disconnect(this);
+  foreach (ParseWorker *worker, workers_)
+    worker->disconnect(this);
+}
+
+/** @brief Set workers that parse data in own threads
+ * @details Without workers data is parsed in thread of parse object
+ *----------------------------------------------------------------------------*/
+void ParseObject::setWorkers(const QList<ParseWorker*> &workers)
+{
+  workers_ = workers;
+  foreach (ParseWorker *worker, workers_) {
+    workerJobs_.insert(worker, 0);
+    connect(worker, SIGNAL(parsed()),
+            this, SLOT(slotParsed()), Qt::QueuedConnection);
+  }
 }
 
 /** @brief Queueing xml-data
+ * @param etag, lastModified - validators of reply
+ * @param contentDigest - digest of data to skip it when it is fetched again
+ * @details Validators and digest are saved only after news of this data
+ *   are written
  *----------------------------------------------------------------------------*/
 void ParseObject::parseXml(QByteArray data, int feedId,
-                           QDateTime dtReply, QString codecName)
+                           QDateTime dtReply, QString codecName,
+                           QString etag, QString lastModified,
+                           QString contentDigest)
+{
+  if (mainApp->isSaveDataLastFeed()) {
+    QFile file(mainApp->dataDir()  + "/lastfeed.dat");
+    file.open(QIODevice::WriteOnly);
+    file.write(data);
+    file.close();
+  }
+
+  QueuedXml queuedXml;
+  queuedXml.feedId = feedId;
+  queuedXml.dtReply = dtReply;
+  queuedXml.codecName = codecName;
+  queuedXml.etag = etag;
+  queuedXml.lastModified = lastModified;
+  queuedXml.contentDigest = contentDigest;
+
+  // Data that is still arriving after queue got full is kept on disk
+  if (queueFull_ && spillQueue_)
+    queuedXml.spillFile = spillData(data);
+  if (queuedXml.spillFile.isEmpty()) {
+    queuedXml.data = data;
+    queueBytes_ += data.size();
+  }
+
+  xmlQueue_.enqueue(queuedXml);
+  updateQueueState();
+  qCDebug(lcParse) << "xmlQueue_ <<" << feedId << "count=" << xmlQueue_.count()
+                   << "bytes=" << queueBytes_;
+
+  scheduleDispatch();
+}
+
+/** @brief Process queue on next pass of event loop
+ * @details Several data arrived at once are dispatched together
+ *----------------------------------------------------------------------------*/
+void ParseObject::scheduleDispatch()
 {
-  idsQueue_.enqueue(feedId);
-  xmlsQueue_.enqueue(data);
-  dtReadyQueue_.enqueue(dtReply);
-  codecNameQueue_.enqueue(codecName);
-  qDebug() << "xmlsQueue_ <<" << feedId << "count=" << xmlsQueue_.count();
-
-  if (!parseTimer_->isActive())
-    parseTimer_->start();
+  if (dispatchPending_)
+    return;
+  dispatchPending_ = true;
+  QMetaObject::invokeMethod(this, "getQueuedXml", Qt::QueuedConnection);
 }
 
 /** @brief Process xml-data queue
+ *
+ * With workers all queued data is dispatched while workers have free
+ * slots. Jobs are counted until their results are written, so parsed
+ * feeds waiting for database are limited too. Without workers one feed
+ * is parsed per pass, so other objects of thread are not held up
  *----------------------------------------------------------------------------*/
 void ParseObject::getQueuedXml()
 {
-  if (!mutex_.tryLock())
-    return;
+  dispatchPending_ = false;
 
-  if (idsQueue_.count()) {
-    int feedId = idsQueue_.dequeue();
-    QByteArray currentXml_ = xmlsQueue_.dequeue();
-    QDateTime currentDtReady_ = dtReadyQueue_.dequeue();
-    QString currentCodecName_ = codecNameQueue_.dequeue();
-    qDebug() << "xmlsQueue_ >>" << feedId << "count=" << xmlsQueue_.count();
+  while (!xmlQueue_.isEmpty()) {
+    ParseWorker *worker = freeWorker();
+    if (!workers_.isEmpty() && !worker)
+      return;  // dispatch is resumed by slotParsed()
 
-    emit signalReadyParse(currentXml_, feedId, currentDtReady_, currentCodecName_);
+    QueuedXml queuedXml = xmlQueue_.dequeue();
+    if (queuedXml.spillFile.isEmpty())
+      queueBytes_ -= queuedXml.data.size();
+    else
+      queuedXml.data = readSpilledData(queuedXml.spillFile);
+    updateQueueState();
+    qCDebug(lcParse) << "xmlQueue_ >>" << queuedXml.feedId << "count=" << xmlQueue_.count()
+                     << "bytes=" << queueBytes_;
+
+    if (!worker) {
+      slotParse(queuedXml.data, queuedXml.feedId, queuedXml.dtReply, queuedXml.codecName,
+                queuedXml.etag, queuedXml.lastModified, queuedXml.contentDigest);
+      if (!xmlQueue_.isEmpty())
+        scheduleDispatch();
+      return;
+    }
+
+    ParseJob job;
+    if (!prepareJob(queuedXml.feedId, &job))
+      continue;
+    job.data = queuedXml.data;
+    job.dtReply = queuedXml.dtReply;
+    job.codecName = queuedXml.codecName;
+    job.etag = queuedXml.etag;
+    job.lastModified = queuedXml.lastModified;
+    job.contentDigest = queuedXml.contentDigest;
+
+    workerJobs_[worker]++;
+    QMetaObject::invokeMethod(worker, "parse", Qt::QueuedConnection,
+                              Q_ARG(ParseJob, job));
   }
+}
 
-  mutex_.unlock();
+/** @brief Track queue size and ask for pause of requests when it is full
+ * @details Requests are resumed when queue is drained to half of limit
+ *----------------------------------------------------------------------------*/
+void ParseObject::updateQueueState()
+{
+  if (!queueFull_ && (maxQueueBytes_ > 0) && (queueBytes_ >= maxQueueBytes_)) {
+    queueFull_ = true;
+    qCDebug(lcParse) << "Parse queue full:" << queueBytes_ << "bytes";
+    emit signalQueueFull(true);
+  } else if (queueFull_ && (queueBytes_ <= maxQueueBytes_ / 2)) {
+    queueFull_ = false;
+    qCDebug(lcParse) << "Parse queue resumed:" << queueBytes_ << "bytes";
+    emit signalQueueFull(false);
+  }
 
-  if (idsQueue_.count())
-    parseTimer_->start();
+  Tracer::addCounter("parseQueue", "depth", xmlQueue_.count());
+  Tracer::addCounter("parseQueueBytes", "bytes", queueBytes_);
 }
 
-/** @brief Parse xml-data
+/** @brief Write queued data into temporary file
+ * @return file name or empty string on error
  *----------------------------------------------------------------------------*/
-void ParseObject::slotParse(const QByteArray &xmlData, const int &feedId,
-                            const QDateTime &dtReply, const QString &codecName)
+QString ParseObject::spillData(const QByteArray &data)
 {
-  if (mainApp->isSaveDataLastFeed()) {
-    QFile file(mainApp->dataDir()  + "/lastfeed.dat");
-    file.open(QIODevice::WriteOnly);
-    file.write(xmlData);
+  QTemporaryFile file(QDir::tempPath() + "/quiterss-parse-XXXXXX.dat");
+  file.setAutoRemove(false);
+  if (!file.open())
+    return QString();
+  if (file.write(data) != data.size()) {
+    qWarning() << "Can't write parse queue file:" << file.fileName();
+    file.remove();
+    return QString();
+  }
+  file.close();
+  return file.fileName();
+}
+
+QByteArray ParseObject::readSpilledData(const QString &fileName)
+{
+  QByteArray data;
+  QFile file(fileName);
+  if (file.open(QIODevice::ReadOnly)) {
+    data = file.readAll();
     file.close();
   }
+  file.remove();
+  return data;
+}
+
+/** @brief Worker with least jobs, 0 if all workers are busy
+ *----------------------------------------------------------------------------*/
+ParseWorker *ParseObject::freeWorker() const
+{
+  ParseWorker *leastBusy = 0;
+  int minJobs = WORKER_MAX_JOBS;
+  foreach (ParseWorker *worker, workers_) {
+    int jobs = workerJobs_.value(worker);
+    if (jobs < minJobs) {
+      minJobs = jobs;
+      leastBusy = worker;
+    }
+  }
+  return leastBusy;
+}
+
+/** @brief Fill job with feed url, finish update if feed is not found
+ *----------------------------------------------------------------------------*/
+bool ParseObject::prepareJob(int feedId, ParseJob *job)
+{
+  QSqlQuery q(db_);
+  q.setForwardOnly(true);
+  q.exec(QString("SELECT xmlUrl FROM feeds WHERE id=='%1'").arg(feedId));
+  if (q.first())
+    job->feedUrl = q.value(0).toString();
+
+  // id not found (ex. feed deleted while updating)
+  if (job->feedUrl.isEmpty()) {
+    qWarning() << QString("Feed with id = '%1' not found").arg(feedId);
+    emit signalFinishUpdate(feedId, false, 0, "0");
+    return false;
+  }
+
+  // Hashes of stored items let worker skip republished items
+  q.exec(QString("SELECT itemHash FROM news WHERE feedId='%1' AND itemHash IS NOT NULL").
+         arg(feedId));
+  while (q.next())
+    job->knownHashes.insert(q.value(0).toLongLong());
 
-  qDebug() << "=================== parseXml:start ============================";
+  job->feedId = feedId;
+  return true;
+}
+
+/** @brief Parse xml-data in thread of parse object
+ *----------------------------------------------------------------------------*/
+void ParseObject::slotParse(const QByteArray &xmlData, const int &feedId,
+                            const QDateTime &dtReply, const QString &codecName,
+                            const QString &etag, const QString &lastModified,
+                            const QString &contentDigest)
+{
+  ParseJob job;
+  if (!prepareJob(feedId, &job))
+    return;
+  job.data = xmlData;
+  job.dtReply = dtReply;
+  job.codecName = codecName;
+  job.etag = etag;
+  job.lastModified = lastModified;
+  job.contentDigest = contentDigest;
+
+  localWorker_->parseFeed(job);
+}
+
+/** @brief Write batches parsed by workers and dispatch next queued data
+ *
+ * Batches of one feed are written in order until its last batch, then
+ * queues of workers are taken in turn. Next feed is written on next pass
+ * of event loop, so other objects of thread are not held up
+ *----------------------------------------------------------------------------*/
+void ParseObject::slotParsed()
+{
+  QList<ParseWorker*> workers = workers_;
+  if (workers.isEmpty())
+    workers.append(localWorker_);
+
+  ParsedFeed batch;
+  forever {
+    ParseWorker *worker = writingWorker_;
+    if (worker) {
+      if (!worker->takeParsed(&batch))
+        break;  // next batch of feed isn't parsed yet
+    } else {
+      for (int i = 0; i < workers.count(); ++i) {
+        int index = (nextWorker_ + i) % workers.count();
+        if (workers.at(index)->takeParsed(&batch)) {
+          worker = workers.at(index);
+          nextWorker_ = (index + 1) % workers.count();
+          break;
+        }
+      }
+      if (!worker)
+        break;
+    }
+
+    writeParsedBatch(batch);
+
+    if (!batch.last) {
+      writingWorker_ = worker;
+      continue;
+    }
+    writingWorker_ = 0;
+    if (workerJobs_.contains(worker))
+      workerJobs_[worker]--;
+    if (!workers_.isEmpty()) {
+      QMetaObject::invokeMethod(this, "slotParsed", Qt::QueuedConnection);
+      break;
+    }
+  }
+
+  if (!xmlQueue_.isEmpty())
+    scheduleDispatch();
+}
+
+/** @brief Write batch of parsed feed into base in own transaction
+ *
+ * News of batches before XML error stay in base: they are complete items,
+ * and as validators aren't saved, data is parsed again next time and these
+ * news are found as duplicates. Transaction isn't kept open between
+ * batches, connection is shared with update object of the same thread
+ *----------------------------------------------------------------------------*/
+void ParseObject::writeParsedBatch(const ParsedFeed &batch)
+{
+  TraceSpan writeSpan("write", batch.feedId);
 
   db_.transaction();
 
-  // extract feed id, duplicate news mode and date to avoid from feed table
-  parseFeedId_ = feedId;
-  QString feedUrl;
+  if (!writeStarted_) {
+    beginFeedWrite(batch);
+    writeStarted_ = true;
+  }
+
+  // id not found (ex. feed deleted while parsing)
+  if (writeFeedUrl_.isEmpty()) {
+    if (batch.last) {
+      writeStarted_ = false;
+      emit signalFinishUpdate(parseFeedId_, false, 0, "0");
+    }
+    db_.commit();
+    return;
+  }
+
+  const QString &feedType = batch.feedType;
+  if ((feedType == "feed") || (feedType == "rss") || (feedType == "rdf:RDF")) {
+    foreach (NewsItemStruct newsItem, batch.newsList) {
+      if (feedType == "feed")
+        addAtomNewsIntoBase(&newsItem);
+      else
+        addRssNewsIntoBase(&newsItem);
+    }
+    flushNewsBatch();
+    flushItemHashes();
+    writtenItems_ += batch.newsList.count();
+  }
+
+  if (!batch.last) {
+    db_.commit();
+    return;
+  }
+
+  int newCount = finishFeedWrite(batch);
+  writeStarted_ = false;
+  db_.commit();
+
+  // News before error are written already, feed shows error status
+  QString status = "0";
+  if (batch.hasError)
+    status = QString("-6 %1").arg(tr("Data is not a complete feed!"));
+  emit signalFinishUpdate(parseFeedId_, feedChanged_, newCount, status);
+  qCDebug(lcParse) << "=================== writeFeed:finish ===========================";
+}
+
+/** @brief Read settings and stored news of feed before its first batch
+ *----------------------------------------------------------------------------*/
+void ParseObject::beginFeedWrite(const ParsedFeed &batch)
+{
+  qCDebug(lcParse) << "=================== writeFeed:start ============================";
+
+  // extract duplicate news mode and date to avoid from feed table
+  parseFeedId_ = batch.feedId;
+  writeFeedUrl_.clear();
+  writtenItems_ = 0;
   duplicateNewsMode_ = false;
   addSingleNewsAnyDate_ = false;
   avoidedOldSingleNews_ = false;
@@ -124,94 +438,25 @@ void ParseObject::slotParse(const QByteArray &xmlData, const int &feedId,
                  " FROM feeds WHERE id=='%1'").arg(parseFeedId_));
   if (q.first()) {
     duplicateNewsMode_ = q.value(0).toBool();
-    feedUrl = q.value(1).toString();
+    writeFeedUrl_ = q.value(1).toString();
     addSingleNewsAnyDate_ = q.value(2).toBool();
     avoidedOldSingleNews_ = q.value(3).toBool();
     avoidedOldSingleNewsDate_ = q.value(4).toDate();
   }
 
-  // id not found (ex. feed deleted while updating)
-  if (feedUrl.isEmpty()) {
+  if (writeFeedUrl_.isEmpty()) {
     qWarning() << QString("Feed with id = '%1' not found").arg(parseFeedId_);
-    emit signalFinishUpdate(parseFeedId_, false, 0, "0");
-    db_.commit();
     return;
   }
 
-  qDebug() << QString("Feed '%1' found with id = %2").arg(feedUrl).arg(parseFeedId_);
-
-  // actually parsing
   feedChanged_ = false;
-  lastBuildDate_ = dtReply;
-
-  bool codecOk = false;
-  QString convertData(xmlData);
-  QString feedType;
-  QDomDocument doc;
-  QString errorStr;
-  int errorLine;
-  int errorColumn;
-
-  QzRegExp rx("encoding=\"([^\"]+)", Qt::CaseInsensitive);
-  int pos = rx.indexIn(xmlData);
-  if (pos == -1) {
-    rx.setPattern("encoding='([^']+)");
-    pos = rx.indexIn(xmlData);
-  }
-  if (pos > -1) {
-    QString codecNameT = rx.cap(1);
-    qDebug() << "Codec name (1):" << codecNameT;
-    QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
-    if (codec) {
-      convertData = codec->toUnicode(xmlData);
-    } else {
-      qWarning() << "Codec not found (1): " << codecNameT << feedUrl;
-      if (codecNameT.contains("us-ascii", Qt::CaseInsensitive)) {
-        QString str(xmlData);
-        convertData = str.remove(rx.cap(0)+"\"");
-      }
-    }
-  } else {
-    if (!codecName.isEmpty()) {
-      qDebug() << "Codec name (2):" << codecName;
-      QTextCodec *codec = QTextCodec::codecForName(codecName.toUtf8());
-      if (codec) {
-        convertData = codec->toUnicode(xmlData);
-        codecOk = true;
-      } else {
-        qWarning() << "Codec not found (2): " << codecName << feedUrl;
-      }
-    }
-    if (!codecOk) {
-      codecOk = false;
-      QStringList codecNameList;
-      codecNameList << "UTF-8" << "Windows-1251" << "KOI8-R" << "KOI8-U"
-                    << "ISO 8859-5" << "IBM 866";
-      foreach (QString codecNameT, codecNameList) {
-        QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
-        if (codec && codec->canEncode(xmlData)) {
-          qDebug() << "Codec name (3):" << codecNameT;
-          convertData = codec->toUnicode(xmlData);
-          codecOk = true;
-          break;
-        }
-      }
-      if (!codecOk) {
-        convertData = QString::fromLocal8Bit(xmlData);
-      }
-    }
-  }
-
-  if (!doc.setContent(convertData, false, &errorStr, &errorLine, &errorColumn)) {
-    qWarning() << QString("Parse data error (2): url %1, id %2, line %3, column %4: %5").
-                  arg(feedUrl).arg(parseFeedId_).
-                  arg(errorLine).arg(errorColumn).arg(errorStr);
-  } else {
-    QDomElement rootElem = doc.documentElement();
-    feedType = rootElem.tagName();
-    qDebug() << "Feed type: " << feedType;
+  lastBuildDate_ = batch.dtReply;
+  insertedNewsCount_ = 0;
+  insertNewsTime_ = 0;
 
-    q.exec(QString("SELECT id, guid, title, published, link_href FROM news WHERE feedId='%1'").
+  const QString &feedType = batch.feedType;
+  if ((feedType == "feed") || (feedType == "rss") || (feedType == "rdf:RDF")) {
+    q.exec(QString("SELECT id, guid, title, published, link_href, itemHash FROM news WHERE feedId='%1'").
            arg(parseFeedId_));
     if (q.lastError().isValid()) {
       qWarning() << __PRETTY_FUNCTION__ << __LINE__
@@ -219,272 +464,289 @@ void ParseObject::slotParse(const QByteArray &xmlData, const int &feedId,
     }
     else {
       while (q.next()) {
+        int row = titleList_.count();
         QString str = q.value(2).toString();
         titleList_.append(str);
+        titleIndex_.insert(str, row);
 
         str = q.value(1).toString();
-        guidList_.append(str);
+        guidIndex_.insert(str, row);
 
         str = q.value(3).toString();
         publishedList_.append(str);
+        publishedIndex_.insert(str, row);
         str = q.value(4).toString();
-        linkList_.append(str);
+        linkIndex_.insert(str, row);
+
+        newsIdList_.append(q.value(0).toInt());
+        itemHashList_.append(q.value(5).toLongLong());
       }
     }
     q.finish();
+  }
+}
+
+/** @brief Update feed properties and counters after its last batch
+ * @details Validators and digest are saved in transaction of last batch,
+ *   so data that isn't written completely is requested and parsed again.
+ *   For data with error feed properties, validators and status aren't saved
+ * @return count of new news
+ *----------------------------------------------------------------------------*/
+int ParseObject::finishFeedWrite(const ParsedFeed &batch)
+{
+  QSqlQuery q(db_);
+  q.setForwardOnly(true);
 
-    if (feedType == "feed") {
-      parseAtom(feedUrl, doc);
-    } else if ((feedType == "rss") || (feedType == "rdf:RDF")) {
-      parseRss(feedUrl, doc);
+  const QString &feedType = batch.feedType;
+  if ((feedType == "feed") || (feedType == "rss") || (feedType == "rdf:RDF")) {
+    if (insertedNewsCount_) {
+      qCDebug(lcParse) << QString("Inserted %1 news in %2 ms, total %3 rows/s").
+                  arg(insertedNewsCount_).arg(insertNewsTime_).
+                  arg(totalInsertNewsTime_ ?
+                        totalInsertedNewsCount_ * 1000 / totalInsertNewsTime_ : 0);
+    }
+    if (!batch.hasError)
+      updateFeedInfo(batch);
+
+    int itemsCount = writtenItems_ + batch.unchangedItems;
+    if (itemsCount) {
+      totalItemsCount_ += itemsCount;
+      totalUnchangedItems_ += batch.unchangedItems;
+      Database::addFeedCounter(db_, parseFeedId_, "parsedItems", itemsCount);
+      Database::addFeedCounter(db_, parseFeedId_, "unchangedItems", batch.unchangedItems);
+      qCDebug(lcParse) << QString("Unchanged items %1 of %2, total %3 of %4").
+                  arg(batch.unchangedItems).arg(itemsCount).
+                  arg(totalUnchangedItems_).arg(totalItemsCount_);
     }
 
-    guidList_.clear();
     titleList_.clear();
     publishedList_.clear();
-    linkList_.clear();
+    guidIndex_.clear();
+    linkIndex_.clear();
+    titleIndex_.clear();
+    publishedIndex_.clear();
+    newsIdList_.clear();
+    itemHashList_.clear();
   }
 
   // Set feed update time and receive data from server time
   QString updated = QLocale::c().toString(QDateTime::currentDateTimeUtc(),
                                           "yyyy-MM-ddTHH:mm:ss");
   QString lastBuildDate = lastBuildDate_.toString(Qt::ISODate);
-  q.prepare("UPDATE feeds SET updated=?, lastBuildDate=?, status=0 WHERE id=?");
+  QString qStr("UPDATE feeds SET updated=?, lastBuildDate=?");
+  if (!batch.hasError)
+    qStr.append(", status=0, etag=?, lastModified=?, contentDigest=?");
+  qStr.append(" WHERE id=?");
+  q.prepare(qStr);
   q.addBindValue(updated);
   q.addBindValue(lastBuildDate);
+  if (!batch.hasError) {
+    q.addBindValue(batch.etag);
+    q.addBindValue(batch.lastModified);
+    q.addBindValue(batch.contentDigest);
+  }
   q.addBindValue(parseFeedId_);
   q.exec();
 
   int newCount = 0;
   if (feedChanged_) {
     runUserFilter(parseFeedId_);
-    newCount = recountFeedCounts(parseFeedId_, feedUrl, updated, lastBuildDate);
+    newCount = recountFeedCounts(parseFeedId_, writeFeedUrl_, updated, lastBuildDate);
   }
 
   q.finish();
-  db_.commit();
-
-  emit signalFinishUpdate(parseFeedId_, feedChanged_, newCount, "0");
-  qDebug() << "=================== parseXml:finish ===========================";
+  return newCount;
 }
 
-void ParseObject::parseAtom(const QString &feedUrl, const QDomDocument &doc)
+/** @brief Update feed properties from parsed feed element
+ *----------------------------------------------------------------------------*/
+void ParseObject::updateFeedInfo(const ParsedFeed &parsedFeed)
 {
-  QDomElement rootElem = doc.documentElement();
-  FeedItemStruct feedItem;
-
-  feedItem.linkBase = rootElem.attribute("xml:base");
-  feedItem.title = toPlainText(rootElem.namedItem("title").toElement().text());
-  feedItem.description = rootElem.namedItem("subtitle").toElement().text();
-  feedItem.updated = rootElem.namedItem("updated").toElement().text();
-  feedItem.updated = parseDate(feedItem.updated, feedUrl);
-  QDomElement authorElem = rootElem.namedItem("author").toElement();
-  if (!authorElem.isNull()) {
-    feedItem.author = toPlainText(authorElem.namedItem("name").toElement().text());
-    if (feedItem.author.isEmpty()) feedItem.author = toPlainText(authorElem.text());
-    feedItem.authorUri = authorElem.namedItem("uri").toElement().text();
-    feedItem.authorEmail = authorElem.namedItem("email").toElement().text();
-  }
-  feedItem.language = rootElem.namedItem("language").toElement().text();
-  QDomNodeList linksList = rootElem.elementsByTagName("link");
-  for (int j = 0; j < linksList.size(); j++) {
-    if (linksList.at(j).toElement().attribute("rel") == "alternate") {
-      feedItem.link = linksList.at(j).toElement().attribute("href");
-      break;
-    }
-  }
-  if (feedItem.link.isEmpty()) {
-    for (int j = 0; j < linksList.size(); j++) {
-        if (!(linksList.at(j).toElement().attribute("rel") == "self")) {
-          feedItem.link = linksList.at(j).toElement().attribute("href");
-          break;
-        }
-    }
+  const FeedItemStruct &feedItem = parsedFeed.feedItem;
+  QSqlQuery q(db_);
+  q.setForwardOnly(true);
+  if (parsedFeed.feedType == "feed") {
+    QString qStr("UPDATE feeds "
+                 "SET title=?, description=?, htmlUrl=?, "
+                 "author_name=?, author_email=?, "
+                 "author_uri=?, pubdate=?, language=? "
+                 "WHERE id==?");
+    q.prepare(qStr);
+    q.addBindValue(feedItem.title);
+    q.addBindValue(feedItem.description);
+    q.addBindValue(feedItem.link);
+    q.addBindValue(feedItem.author);
+    q.addBindValue(feedItem.authorEmail);
+    q.addBindValue(feedItem.authorUri);
+    q.addBindValue(feedItem.updated);
+    q.addBindValue(feedItem.language);
+    q.addBindValue(parseFeedId_);
+    q.exec();
+  } else {
+    QString qStr("UPDATE feeds "
+                 "SET title=?, description=?, htmlUrl=?, "
+                 "author_name=?, pubdate=?, language=? "
+                 "WHERE id==?");
+    q.prepare(qStr);
+    q.addBindValue(feedItem.title);
+    q.addBindValue(feedItem.description);
+    q.addBindValue(feedItem.link);
+    q.addBindValue(feedItem.author);
+    q.addBindValue(feedItem.updated);
+    q.addBindValue(feedItem.language);
+    q.addBindValue(parseFeedId_);
+    q.exec();
   }
+}
 
-  if (QUrl(feedItem.link).host().isEmpty() || (QUrl(feedItem.link).host().indexOf('.')) == -1) {
-    if (!feedItem.linkBase.isEmpty() && !QUrl(feedItem.linkBase).host().isEmpty())
-      feedItem.link = QUrl(feedItem.linkBase).scheme() %  "://" % QUrl(feedItem.linkBase).host();
-    else
-      feedItem.link = QUrl(feedUrl).scheme() %  "://" % QUrl(feedUrl).host();
-  }
-  if (feedItem.linkBase.isEmpty() && !QUrl(feedItem.link).host().isEmpty())
-    feedItem.linkBase = QUrl(feedItem.link).scheme() %  "://" % QUrl(feedItem.link).host();
-  if (QUrl(feedItem.link).host().isEmpty())
-    feedItem.link = feedItem.linkBase + feedItem.link;
-  feedItem.link = toPlainText(feedItem.link);
-  QUrl url = QUrl(feedItem.link);
-  if (url.scheme().isEmpty())
-    url.setScheme(QUrl(feedUrl).scheme());
-  feedItem.link = url.toString();
+/** @brief Queue news for insertion into base
+ *
+ * News are written by flushNewsBatch() with one prepared statement per
+ * batch inside parse transaction
+ *----------------------------------------------------------------------------*/
+void ParseObject::addNewsIntoBatch(const NewsItemStruct &newsItem, bool read)
+{
+  if (newsBatch_.isEmpty())
+    newsBatch_.resize(NEWS_COLUMNS);
+
+  QString updated = newsItem.updated;
+  if (updated.isEmpty())
+    updated = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+
+  int column = 0;
+  newsBatch_[column++] << parseFeedId_;
+  newsBatch_[column++] << newsItem.description;
+  newsBatch_[column++] << newsItem.content;
+  newsBatch_[column++] << newsItem.id;
+  newsBatch_[column++] << newsItem.title;
+  newsBatch_[column++] << newsItem.author;
+  newsBatch_[column++] << newsItem.authorUri;
+  newsBatch_[column++] << newsItem.authorEmail;
+  newsBatch_[column++] << updated;
+  newsBatch_[column++] << QDateTime::currentDateTime().toString(Qt::ISODate);
+  newsBatch_[column++] << newsItem.link;
+  newsBatch_[column++] << newsItem.linkAlternate;
+  newsBatch_[column++] << newsItem.category;
+  newsBatch_[column++] << newsItem.comments;
+  newsBatch_[column++] << newsItem.eUrl;
+  newsBatch_[column++] << newsItem.eType;
+  newsBatch_[column++] << newsItem.eLength;
+  newsBatch_[column++] << (read ? 0 : 1);
+  newsBatch_[column++] << (read ? 2 : 0);
+  newsBatch_[column++] << Database::titleHash(newsItem.title);
+  newsBatch_[column++] << newsItem.itemHash;
+
+  if (newsBatch_.at(0).count() >= NEWS_BATCH_SIZE)
+    flushNewsBatch();
+}
+
+void ParseObject::flushNewsBatch()
+{
+  if (newsBatch_.isEmpty() || newsBatch_.at(0).isEmpty())
+    return;
+
+  TraceSpan span("insert", parseFeedId_);
+  QElapsedTimer timer;
+  timer.start();
 
   QSqlQuery q(db_);
-  q.setForwardOnly(true);
-  QString qStr ("UPDATE feeds "
-                "SET title=?, description=?, htmlUrl=?, "
-                "author_name=?, author_email=?, "
-                "author_uri=?, pubdate=?, language=? "
-                "WHERE id==?");
-  q.prepare(qStr);
-  q.addBindValue(feedItem.title);
-  q.addBindValue(feedItem.description);
-  q.addBindValue(feedItem.link);
-  q.addBindValue(feedItem.author);
-  q.addBindValue(feedItem.authorEmail);
-  q.addBindValue(feedItem.authorUri);
-  q.addBindValue(feedItem.updated);
-  q.addBindValue(feedItem.language);
-  q.addBindValue(parseFeedId_);
-  q.exec();
+  q.prepare("INSERT INTO news("
+            "feedId, description, content, guid, title, author_name, "
+            "author_uri, author_email, published, received, "
+            "link_href, link_alternate, category, comments, "
+            "enclosure_url, enclosure_type, enclosure_length, new, read, titleHash, itemHash) "
+            "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+  for (int i = 0; i < newsBatch_.count(); ++i) {
+    q.addBindValue(newsBatch_.at(i));
+  }
+  if (!q.execBatch()) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
+  }
+  q.finish();
 
-  QDomNodeList newsList = doc.elementsByTagName("entry");
-  for (int i = 0; i < newsList.size(); i++) {
-    NewsItemStruct newsItem;
-    newsItem.id = newsList.item(i).namedItem("id").toElement().text();
-    newsItem.title = toPlainText(newsList.item(i).namedItem("title").toElement().text());
-    newsItem.updated = newsList.item(i).namedItem("published").toElement().text();
-    if (newsItem.updated.isEmpty())
-      newsItem.updated = newsList.item(i).namedItem("updated").toElement().text();
-    newsItem.updated = parseDate(newsItem.updated, feedUrl);
-    QDomElement authorElem = newsList.item(i).namedItem("author").toElement();
-    if (!authorElem.isNull()) {
-      newsItem.author = toPlainText(authorElem.namedItem("name").toElement().text());
-      if (newsItem.author.isEmpty()) newsItem.author = toPlainText(authorElem.text());
-      newsItem.authorUri = authorElem.namedItem("uri").toElement().text();
-      newsItem.authorEmail = authorElem.namedItem("email").toElement().text();
-    }
+  int count = newsBatch_.at(0).count();
+  qint64 elapsed = timer.elapsed();
+  insertedNewsCount_ += count;
+  insertNewsTime_ += elapsed;
+  totalInsertedNewsCount_ += count;
+  totalInsertNewsTime_ += elapsed;
+  newsBatch_.clear();
+}
 
-    newsItem.description = newsList.item(i).namedItem("summary").toElement().text();
-    QDomNode nodeSummary = newsList.item(i).namedItem("summary");
-    if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
-      QTextStream in(&newsItem.description);
-      nodeSummary.save(in, 0);
-    }
-    QDomNode nodeContent = newsList.item(i).namedItem("content");
-    if (nodeContent.toElement().attribute("type") == "xhtml") {
-      QTextStream in(&newsItem.content);
-      nodeContent.save(in, 0);
-    } else {
-      newsItem.content = nodeContent.toElement().text();
-    }
-    QString imgUrl = newsList.item(i).namedItem("media:thumbnail").toElement().attribute("url");
-    QString community = getCommunity(newsList.item(i).namedItem("media:community"));
-    nodeContent = newsList.item(i).namedItem("media:group");
-    if (!nodeContent.isNull()) {
-      QString description = nodeContent.namedItem("media:description").toElement().text();
-      if (description.length() > newsItem.content.length())
-        newsItem.content = description;
-      newsItem.content = fromPlainText(newsItem.content);
-      if (imgUrl.isEmpty())
-        imgUrl = nodeContent.namedItem("media:thumbnail").toElement().attribute("url");
-      if (community.isEmpty())
-        community = getCommunity(nodeContent.namedItem("media:community"));
-    }
-    if (!(newsItem.content.isEmpty() ||
-          (newsItem.description.length() > newsItem.content.length()))) {
-      newsItem.description = newsItem.content;
-    }
-    newsItem.content.clear();
-    if (!imgUrl.isEmpty()) {
-      newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
-      newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
-    }
-    if (!community.isEmpty())
-      newsItem.description += community;
-
-    QDomNodeList categoryElem = newsList.item(i).toElement().elementsByTagName("category");
-    for (int j = 0; j < categoryElem.size(); j++) {
-      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
-      QString category = categoryElem.at(j).toElement().attribute("label");
-      if (category.isEmpty())
-        category = categoryElem.at(j).toElement().attribute("term");
-      newsItem.category.append(toPlainText(category));
-    }
-    QDomElement enclosureElem = newsList.item(i).namedItem("enclosure").toElement();
-    newsItem.eUrl = enclosureElem.attribute("url");
-    newsItem.eType = enclosureElem.attribute("type");
-    newsItem.eLength = enclosureElem.attribute("length");
-    QDomNodeList linksList = newsList.item(i).toElement().elementsByTagName("link");
-    for (int j = 0; j < linksList.size(); j++) {
-      if (linksList.at(j).toElement().attribute("type") == "text/html") {
-        if (linksList.at(j).toElement().attribute("rel") == "self")
-          newsItem.link = linksList.at(j).toElement().attribute("href");
-        if (linksList.at(j).toElement().attribute("rel") == "alternate")
-          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
-        if (linksList.at(j).toElement().attribute("rel") == "replies")
-          newsItem.comments = linksList.at(j).toElement().attribute("href");
-      } else if (newsItem.linkAlternate.isEmpty()) {
-        if (linksList.at(j).toElement().attribute("rel") == "alternate")
-          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
-      }
-    }
-    for (int j = 0; j < linksList.size(); j++) {
-      if (newsItem.linkAlternate.isEmpty()) {
-        if (!(linksList.at(j).toElement().attribute("rel") == "self")) {
-          newsItem.linkAlternate = linksList.at(j).toElement().attribute("href");
-          break;
-        }
-      }
-    }
+/** @brief Remember hash of item on stored news it duplicates
+ * @details News stored before item hashes or with other raw data of item
+ *   get hash, so item is skipped by worker next time
+ *----------------------------------------------------------------------------*/
+void ParseObject::setItemHash(int row, qint64 hash)
+{
+  if ((row < 0) || (itemHashList_.at(row) == hash))
+    return;
 
-    if (!newsItem.link.isEmpty() && QUrl(newsItem.link).host().isEmpty())
-      newsItem.link = feedItem.linkBase + newsItem.link;
-    newsItem.link = toPlainText(newsItem.link);
-    if (!newsItem.linkAlternate.isEmpty() && QUrl(newsItem.linkAlternate).host().isEmpty())
-      newsItem.linkAlternate = feedItem.linkBase + newsItem.linkAlternate;
-    newsItem.linkAlternate = toPlainText(newsItem.linkAlternate);
-    if (newsItem.link.isEmpty()) {
-      newsItem.link = newsItem.linkAlternate;
-      newsItem.linkAlternate.clear();
-    }
-    url = QUrl(newsItem.link);
-    if (url.scheme().isEmpty())
-      url.setScheme(QUrl(feedUrl).scheme());
-    newsItem.link = url.toString();
+  itemHashList_[row] = hash;
+  itemHashBatch_[0] << hash;
+  itemHashBatch_[1] << newsIdList_.at(row);
+}
 
-    addAtomNewsIntoBase(&newsItem);
+void ParseObject::flushItemHashes()
+{
+  if (itemHashBatch_[0].isEmpty())
+    return;
+
+  QSqlQuery q(db_);
+  q.prepare("UPDATE news SET itemHash=? WHERE id=?");
+  q.addBindValue(itemHashBatch_[0]);
+  q.addBindValue(itemHashBatch_[1]);
+  if (!q.execBatch()) {
+    qWarning() << __PRETTY_FUNCTION__ << __LINE__
+               << "q.lastError(): " << q.lastError().text();
   }
+  itemHashBatch_[0].clear();
+  itemHashBatch_[1].clear();
 }
 
+
 void ParseObject::addAtomNewsIntoBase(NewsItemStruct *newsItem)
 {
-  Common::sleep(5);
-
   // search news duplicates in base
   QSqlQuery q(db_);
   q.setForwardOnly(true);
-  QString qStr;
-  qDebug() << "atomId:" << newsItem->id;
-  qDebug() << "title:" << newsItem->title;
-  qDebug() << "published:" << newsItem->updated;
+  qCDebug(lcParse) << "atomId:" << newsItem->id;
+  qCDebug(lcParse) << "title:" << newsItem->title;
+  qCDebug(lcParse) << "published:" << newsItem->updated;
 
+  TraceSpan dedupeSpan("dedupe", parseFeedId_);
   bool isDuplicate = false;
-  for (int i = 0; i < guidList_.count(); ++i) {
-    if (!newsItem->id.isEmpty()) {         // search by guid if present
-      if (guidList_.at(i) == newsItem->id) {
-        if (duplicateNewsMode_) {       // autodelete duplicate news enabled
-          isDuplicate = true;
-        } else {                        // autodelete dupl. news disabled
-          if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
-            if (publishedList_.at(i) == newsItem->updated)
-              isDuplicate = true;
-          } else {                      // ... or by title
-            if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
-              isDuplicate = true;
-          }
+  int duplicateRow = -1;
+  if (!newsItem->id.isEmpty()) {         // search by guid if present
+    foreach (int i, guidIndex_.values(newsItem->id)) {
+      if (duplicateNewsMode_) {       // autodelete duplicate news enabled
+        isDuplicate = true;
+      } else {                        // autodelete dupl. news disabled
+        if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
+          if (publishedList_.at(i) == newsItem->updated)
+            isDuplicate = true;
+        } else {                      // ... or by title
+          if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
+            isDuplicate = true;
         }
       }
-    } else {                                // guid is absent
-      if (!newsItem->updated.isEmpty()) {    // search by pubDate if present
-        if (publishedList_.at(i) == newsItem->updated)
-          isDuplicate = true;
-      } else {                              // ... or by title
-        if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
-          isDuplicate = true;
+      if (isDuplicate) {
+        duplicateRow = i;
+        break;
       }
     }
-    if (isDuplicate) break;
+  } else {                                // guid is absent
+    if (!newsItem->updated.isEmpty()) {    // search by pubDate if present
+      duplicateRow = publishedIndex_.value(newsItem->updated, -1);
+    } else if (!newsItem->title.isEmpty()) {  // ... or by title
+      duplicateRow = titleIndex_.value(newsItem->title, -1);
+    }
+    isDuplicate = (duplicateRow >= 0);
   }
+  setItemHash(duplicateRow, newsItem->itemHash);
+
+  dedupeSpan.finish();
 
   // Verify old news before a date to avoid adding them to base
   bool isOld = false;
@@ -503,65 +765,16 @@ void ParseObject::addAtomNewsIntoBase(NewsItemStruct *newsItem)
   if (!isDuplicate && !isOld) {
     bool read = false;
     if (mainApp->mainWindow()->markIdenticalNewsRead_) {
-      q.prepare("SELECT id FROM news WHERE title LIKE :title AND feedId!=:id");
+      q.prepare("SELECT id FROM news "
+                "WHERE titleHash=:titleHash AND feedId!=:id AND title LIKE :title");
+      q.bindValue(":titleHash", Database::titleHash(newsItem->title));
       q.bindValue(":id", parseFeedId_);
       q.bindValue(":title", newsItem->title);
       q.exec();
       if (q.first()) read = true;
     }
 
-    qStr = QString("INSERT INTO news("
-                   "feedId, description, content, guid, title, author_name, "
-                   "author_uri, author_email, published, received, "
-                   "link_href, link_alternate, category, comments, "
-                   "enclosure_url, enclosure_type, enclosure_length, new, read) "
-                   "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.prepare(qStr);
-    q.addBindValue(parseFeedId_);
-    q.addBindValue(newsItem->description);
-    q.addBindValue(newsItem->content);
-    q.addBindValue(newsItem->id);
-    q.addBindValue(newsItem->title);
-    q.addBindValue(newsItem->author);
-    q.addBindValue(newsItem->authorUri);
-    q.addBindValue(newsItem->authorEmail);
-    QString updated = newsItem->updated;
-    if (updated.isEmpty())
-      updated = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
-    q.addBindValue(updated);
-    q.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-    q.addBindValue(newsItem->link);
-    q.addBindValue(newsItem->linkAlternate);
-    q.addBindValue(newsItem->category);
-    q.addBindValue(newsItem->comments);
-    q.addBindValue(newsItem->eUrl);
-    q.addBindValue(newsItem->eType);
-    q.addBindValue(newsItem->eLength);
-    q.addBindValue(read ? 0 : 1);
-    q.addBindValue(read ? 2 : 0);
-    if (!q.exec()) {
-      qWarning() << __PRETTY_FUNCTION__ << __LINE__
-                 << "q.lastError(): " << q.lastError().text();
-    }
-    q.finish();
-    qDebug() << "q.exec(" << q.lastQuery() << ")";
-    qDebug() << "       " << parseFeedId_;
-    qDebug() << "       " << newsItem->description;
-    qDebug() << "       " << newsItem->content;
-    qDebug() << "       " << newsItem->id;
-    qDebug() << "       " << newsItem->title;
-    qDebug() << "       " << newsItem->author;
-    qDebug() << "       " << newsItem->authorUri;
-    qDebug() << "       " << newsItem->authorEmail;
-    qDebug() << "       " << newsItem->updated;
-    qDebug() << "       " << QDateTime::currentDateTime().toString();
-    qDebug() << "       " << newsItem->link;
-    qDebug() << "       " << newsItem->linkAlternate;
-    qDebug() << "       " << newsItem->category;
-    qDebug() << "       " << newsItem->comments;
-    qDebug() << "       " << newsItem->eUrl;
-    qDebug() << "       " << newsItem->eType;
-    qDebug() << "       " << newsItem->eLength;
+    addNewsIntoBatch(*newsItem, read);
 
     if (lastBuildDate_ < QDateTime::fromString(newsItem->updated, Qt::ISODate))
       lastBuildDate_ = QDateTime::fromString(newsItem->updated, Qt::ISODate);
@@ -569,211 +782,32 @@ void ParseObject::addAtomNewsIntoBase(NewsItemStruct *newsItem)
   }
 }
 
-void ParseObject::parseRss(const QString &feedUrl, const QDomDocument &doc)
-{
-  QDomNode channel = doc.documentElement().namedItem("channel");
-  if (channel.isNull())
-    channel = doc.documentElement().namedItem("rss:channel");
-  FeedItemStruct feedItem;
-
-  feedItem.title = toPlainText(channel.namedItem("title").toElement().text());
-  if (feedItem.title.isEmpty())
-    feedItem.title = toPlainText(channel.namedItem("rss:title").toElement().text());
-  feedItem.description = channel.namedItem("description").toElement().text();
-  if (feedItem.description.isEmpty())
-    feedItem.description = toPlainText(channel.namedItem("rss:description").toElement().text());
-  feedItem.link = toPlainText(channel.namedItem("link").toElement().text());
-  if (feedItem.link.isEmpty())
-    feedItem.link = toPlainText(channel.namedItem("rss:link").toElement().text());
-  QUrl url = QUrl(feedItem.link);
-  if (url.host().isEmpty())
-    url.setHost(QUrl(feedUrl).host());
-  if (url.scheme().isEmpty())
-    url.setScheme(QUrl(feedUrl).scheme());
-  feedItem.link = url.toString();
-
-  feedItem.updated = channel.namedItem("pubDate").toElement().text();
-  if (feedItem.updated.isEmpty())
-    feedItem.updated = channel.namedItem("pubdate").toElement().text();
-  feedItem.updated = parseDate(feedItem.updated, feedUrl);
-  feedItem.author = toPlainText(channel.namedItem("author").toElement().text());
-  feedItem.language = channel.namedItem("language").toElement().text();
-  if (feedItem.language.isEmpty())
-    feedItem.language = channel.namedItem("dc:language").toElement().text();
-
-  QSqlQuery q(db_);
-  q.setForwardOnly(true);
-  QString qStr("UPDATE feeds "
-               "SET title=?, description=?, htmlUrl=?, "
-               "author_name=?, pubdate=?, language=? "
-               "WHERE id==?");
-  q.prepare(qStr);
-  q.addBindValue(feedItem.title);
-  q.addBindValue(feedItem.description);
-  q.addBindValue(feedItem.link);
-  q.addBindValue(feedItem.author);
-  q.addBindValue(feedItem.updated);
-  q.addBindValue(feedItem.language);
-  q.addBindValue(parseFeedId_);
-  q.exec();
-
-  QDomNodeList newsList = doc.elementsByTagName("item");
-  if (newsList.isEmpty())
-    newsList = doc.elementsByTagName("rss:item");
-  for (int i = 0; i < newsList.size(); i++) {
-    NewsItemStruct newsItem;
-    newsItem.id = newsList.item(i).namedItem("guid").toElement().text();
-    newsItem.title = toPlainText(newsList.item(i).namedItem("title").toElement().text());
-    if (newsItem.title.isEmpty())
-      newsItem.title = toPlainText(newsList.item(i).namedItem("rss:title").toElement().text());
-    newsItem.updated = newsList.item(i).namedItem("pubDate").toElement().text();
-    if (newsItem.updated.isEmpty())
-      newsItem.updated = newsList.item(i).namedItem("pubdate").toElement().text();
-    if (newsItem.updated.isEmpty())
-      newsItem.updated = newsList.item(i).namedItem("dc:date").toElement().text();
-    newsItem.updated = parseDate(newsItem.updated, feedUrl);
-    newsItem.author = toPlainText(newsList.item(i).namedItem("author").toElement().text());
-    if (newsItem.author.isEmpty())
-      newsItem.author = toPlainText(newsList.item(i).namedItem("dc:creator").toElement().text());
-    newsItem.link = toPlainText(newsList.item(i).namedItem("link").toElement().text());
-    if (newsItem.link.isEmpty()) {
-        newsItem.link = toPlainText(newsList.item(i).namedItem("rss:link").toElement().text());
-        if (newsItem.link.isEmpty()) {
-            if (newsList.item(i).namedItem("guid").toElement().attribute("isPermaLink") == "true")
-                newsItem.link = newsItem.id;
-        }
-    }
-    url = QUrl(newsItem.link);
-    if (url.host().isEmpty())
-      url.setHost(QUrl(feedUrl).host());
-    if (url.scheme().isEmpty())
-      url.setScheme(QUrl(feedUrl).scheme());
-    newsItem.link = url.toString();
-
-    newsItem.description = newsList.item(i).namedItem("description").toElement().text();
-    QDomNode nodeSummary = newsList.item(i).namedItem("description");
-    if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
-      QTextStream in(&newsItem.description);
-      nodeSummary.save(in, 0);
-    }
-    newsItem.content = newsList.item(i).namedItem("content:encoded").toElement().text();
-    QDomNode nodeContent = newsList.item(i).namedItem("content:encoded");
-    if (!nodeContent.isNull() && newsItem.content.isEmpty()) {
-      QTextStream in(&newsItem.content);
-      nodeContent.save(in, 0);
-    }
-    QString imgUrl = newsList.item(i).namedItem("media:thumbnail").toElement().attribute("url");
-    QString community = getCommunity(newsList.item(i).namedItem("media:community"));
-    nodeContent = newsList.item(i).namedItem("media:group");
-    if (!nodeContent.isNull()) {
-      QString description = nodeContent.namedItem("media:description").toElement().text();
-      if (description.length() > newsItem.content.length())
-        newsItem.content = description;
-      newsItem.content = fromPlainText(newsItem.content);
-      if (imgUrl.isEmpty())
-        imgUrl = nodeContent.namedItem("media:thumbnail").toElement().attribute("url");
-      if (community.isEmpty())
-        community = getCommunity(nodeContent.namedItem("media:community"));
-    }
-    if (!(newsItem.content.isEmpty() ||
-          (newsItem.description.length() > newsItem.content.length()))) {
-      newsItem.description = newsItem.content;
-    }
-    newsItem.content.clear();
-    if (!imgUrl.isEmpty()) {
-      newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
-      newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
-    }
-    if (!community.isEmpty())
-      newsItem.description += community;
-
-    QDomNodeList categoryElem = newsList.item(i).toElement().elementsByTagName("category");
-    for (int j = 0; j < categoryElem.size(); j++) {
-      if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
-      newsItem.category.append(toPlainText(categoryElem.at(j).toElement().text()));
-    }
-    newsItem.comments = newsList.item(i).namedItem("comments").toElement().text();
-    QDomElement enclosureElem = newsList.item(i).namedItem("enclosure").toElement();
-    newsItem.eUrl = enclosureElem.attribute("url");
-    newsItem.eType = enclosureElem.attribute("type");
-    newsItem.eLength = enclosureElem.attribute("length");
-
-    if (newsItem.title.isEmpty()) {
-      newsItem.title = toPlainText(newsItem.description);
-      if (newsItem.title.size() > 50) {
-        newsItem.title.resize(50);
-        newsItem.title = newsItem.title % "...";
-      }
-    }
-
-    addRssNewsIntoBase(&newsItem);
-  }
-}
 
 void ParseObject::addRssNewsIntoBase(NewsItemStruct *newsItem)
 {
-  Common::sleep(5);
-
   // search news duplicates in base
   QSqlQuery q(db_);
   q.setForwardOnly(true);
-  QString qStr;
-  qDebug() << "guid:     " << newsItem->id;
-  qDebug() << "link_href:" << newsItem->link;
-  qDebug() << "title:"     << newsItem->title;
-  qDebug() << "published:" << newsItem->updated;
+  qCDebug(lcParse) << "guid:     " << newsItem->id;
+  qCDebug(lcParse) << "link_href:" << newsItem->link;
+  qCDebug(lcParse) << "title:"     << newsItem->title;
+  qCDebug(lcParse) << "published:" << newsItem->updated;
 
+  TraceSpan dedupeSpan("dedupe", parseFeedId_);
   bool isDuplicate = false;
-  for (int i = 0; i < guidList_.count(); ++i) {
-    if (!newsItem->id.isEmpty()) {         // search by guid if present
-      if (guidList_.at(i) == newsItem->id) {
-        if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
-          if (!duplicateNewsMode_) {
-            if (publishedList_.at(i) == newsItem->updated)
-              isDuplicate = true;
-          }
-          else {
-            isDuplicate = true;
-          }
-        } else {                            // ... or by title
-          if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
-            isDuplicate = true;
-        }
-      }
-      if (!isDuplicate) {
-        if (!newsItem->updated.isEmpty()) {
-          if ((publishedList_.at(i) == newsItem->updated) &&
-              (titleList_.at(i) == newsItem->title)) {
-            isDuplicate = true;
-          }
-        }
-      }
-    }
-    else if (!newsItem->link.isEmpty()) {   // search by link_href
-      if (linkList_.at(i) == newsItem->link) {
-        if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
-          if (!duplicateNewsMode_) {
-            if (publishedList_.at(i) == newsItem->updated)
-              isDuplicate = true;
-          }
-          else {
-            isDuplicate = true;
-          }
-        } else {                            // ... or by title
-          if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
-            isDuplicate = true;
-        }
-      }
-      if (!isDuplicate) {
-        if (!newsItem->updated.isEmpty()) {
-          if ((publishedList_.at(i) == newsItem->updated) &&
-              (titleList_.at(i) == newsItem->title)) {
-            isDuplicate = true;
-          }
-        }
-      }
-    }
-    else {                                // guid is absent
+  int duplicateRow = -1;
+  const QMultiHash<QString, int> *keyIndex = 0;
+  QString key;
+  if (!newsItem->id.isEmpty()) {         // search by guid if present
+    keyIndex = &guidIndex_;
+    key = newsItem->id;
+  } else if (!newsItem->link.isEmpty()) {  // search by link_href
+    keyIndex = &linkIndex_;
+    key = newsItem->link;
+  }
+
+  if (keyIndex) {
+    foreach (int i, keyIndex->values(key)) {
       if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
         if (!duplicateNewsMode_) {
           if (publishedList_.at(i) == newsItem->updated)
@@ -786,17 +820,37 @@ void ParseObject::addRssNewsIntoBase(NewsItemStruct *newsItem)
         if (!newsItem->title.isEmpty() && (titleList_.at(i) == newsItem->title))
           isDuplicate = true;
       }
-      if (!isDuplicate) {
-        if (!newsItem->updated.isEmpty()) {
-          if ((publishedList_.at(i) == newsItem->updated) &&
-              (titleList_.at(i) == newsItem->title)) {
-            isDuplicate = true;
-          }
-        }
+      if (isDuplicate) {
+        duplicateRow = i;
+        break;
       }
     }
-    if (isDuplicate) break;
   }
+  else {                                // guid is absent
+    if (!newsItem->updated.isEmpty()) {  // search by pubDate if present
+      if (!duplicateNewsMode_) {
+        duplicateRow = publishedIndex_.value(newsItem->updated, -1);
+        isDuplicate = (duplicateRow >= 0);
+      } else {
+        isDuplicate = !publishedList_.isEmpty();
+      }
+    } else if (!newsItem->title.isEmpty()) {  // ... or by title
+      duplicateRow = titleIndex_.value(newsItem->title, -1);
+      isDuplicate = (duplicateRow >= 0);
+    }
+  }
+  if (!isDuplicate && !newsItem->updated.isEmpty()) {  // same pubDate and title
+    foreach (int i, publishedIndex_.values(newsItem->updated)) {
+      if (titleList_.at(i) == newsItem->title) {
+        isDuplicate = true;
+        duplicateRow = i;
+        break;
+      }
+    }
+  }
+  setItemHash(duplicateRow, newsItem->itemHash);
+
+  dedupeSpan.finish();
 
   // Verify old news before a date to avoid adding them to base
   bool isOld = false;
@@ -815,58 +869,16 @@ void ParseObject::addRssNewsIntoBase(NewsItemStruct *newsItem)
  if (!isDuplicate && !isOld) {
     bool read = false;
     if (mainApp->mainWindow()->markIdenticalNewsRead_) {
-      q.prepare("SELECT id FROM news WHERE title LIKE :title AND feedId!=:id");
+      q.prepare("SELECT id FROM news "
+                "WHERE titleHash=:titleHash AND feedId!=:id AND title LIKE :title");
+      q.bindValue(":titleHash", Database::titleHash(newsItem->title));
       q.bindValue(":id", parseFeedId_);
       q.bindValue(":title", newsItem->title);
       q.exec();
       if (q.first()) read = true;
     }
 
-    qStr = QString("INSERT INTO news("
-                   "feedId, description, content, guid, title, author_name, "
-                   "published, received, link_href, category, comments, "
-                   "enclosure_url, enclosure_type, enclosure_length, new, read) "
-                   "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.prepare(qStr);
-    q.addBindValue(parseFeedId_);
-    q.addBindValue(newsItem->description);
-    q.addBindValue(newsItem->content);
-    q.addBindValue(newsItem->id);
-    q.addBindValue(newsItem->title);
-    q.addBindValue(newsItem->author);
-    QString updated = newsItem->updated;
-    if (updated.isEmpty())
-      updated = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
-    q.addBindValue(updated);
-    q.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-    q.addBindValue(newsItem->link);
-    q.addBindValue(newsItem->category);
-    q.addBindValue(newsItem->comments);
-    q.addBindValue(newsItem->eUrl);
-    q.addBindValue(newsItem->eType);
-    q.addBindValue(newsItem->eLength);
-    q.addBindValue(read ? 0 : 1);
-    q.addBindValue(read ? 2 : 0);
-    if (!q.exec()) {
-      qWarning() << __PRETTY_FUNCTION__ << __LINE__
-                 << "q.lastError(): " << q.lastError().text();
-    }
-    q.finish();
-    qDebug() << "q.exec(" << q.lastQuery() << ")";
-    qDebug() << "       " << parseFeedId_;
-    qDebug() << "       " << newsItem->description;
-    qDebug() << "       " << newsItem->content;
-    qDebug() << "       " << newsItem->id;
-    qDebug() << "       " << newsItem->title;
-    qDebug() << "       " << newsItem->author;
-    qDebug() << "       " << newsItem->updated;
-    qDebug() << "       " << QDateTime::currentDateTime().toString();
-    qDebug() << "       " << newsItem->link;
-    qDebug() << "       " << newsItem->category;
-    qDebug() << "       " << newsItem->comments;
-    qDebug() << "       " << newsItem->eUrl;
-    qDebug() << "       " << newsItem->eType;
-    qDebug() << "       " << newsItem->eLength;
+    addNewsIntoBatch(*newsItem, read);
 
     if (lastBuildDate_ < QDateTime::fromString(newsItem->updated, Qt::ISODate))
       lastBuildDate_ = QDateTime::fromString(newsItem->updated, Qt::ISODate);
@@ -874,133 +886,6 @@ void ParseObject::addRssNewsIntoBase(NewsItemStruct *newsItem)
   }
 }
 
-QString ParseObject::toPlainText(const QString &text)
-{
-  return QTextDocumentFragment::fromHtml(text).toPlainText().simplified();
-}
-
-QString ParseObject::fromPlainText(QString text)
-{
-  text = text.replace("\r\n", "<br>");
-  text = text.replace("\n", "<br>");
-  return text;
-}
-
-QString ParseObject::getCommunity(const QDomNode &nodeContent)
-{
-  QString community;
-  if (!nodeContent.isNull()) {
-    QString count = nodeContent.namedItem("media:starRating").toElement().attribute("count");
-    QString average = nodeContent.namedItem("media:starRating").toElement().attribute("average");
-    QString min = nodeContent.namedItem("media:starRating").toElement().attribute("min");
-    QString max = nodeContent.namedItem("media:starRating").toElement().attribute("max");
-    QString views = nodeContent.namedItem("media:statistics").toElement().attribute("views");
-    if (!count.isEmpty())
-      community = QString("Count: %1, average: %2, min: %3, max: %4<br>").
-          arg(count).arg(average).arg(min).arg(max);
-    if (!views.isEmpty())
-      community += QString("Views: %1").arg(views);
-    if (!community.isEmpty())
-      community = "<p><i>" + community + "</i></p>";
-  }
-  return community;
-}
-
-/** @brief Date/time string parsing
- *----------------------------------------------------------------------------*/
-QString ParseObject::parseDate(const QString &dateString, const QString &urlString)
-{
-  QDateTime dt;
-  QString temp;
-  QString timeZone;
-
-  if (dateString.isEmpty()) return QString();
-
-  QDateTime dtLocalTime = QDateTime::currentDateTime();
-  QDateTime dtUTC = QDateTime(dtLocalTime.date(), dtLocalTime.time(), Qt::UTC);
-  int nTimeShift = dtLocalTime.secsTo(dtUTC)/3600;
-
-  QString ds = dateString.simplified();
-  QLocale locale(QLocale::C);
-
-  if (ds.indexOf(',') != -1) {
-    ds = ds.remove(0, ds.indexOf(',')+1).simplified();
-  }
-
-  for (int i = 0; i < 2; i++, locale = QLocale::system()) {
-    temp     = ds.left(23);
-    timeZone = ds.mid(temp.length(), 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss.z");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp     = ds.left(19);
-    timeZone = ds.mid(temp.length(), 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(23);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss.z");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(19);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(20);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.contains("EDT"))
-      timeZone="-4";
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(19);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "d MMM yyyy HH:mm:ss");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(11);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "dd MMM yyyy");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(10);
-    timeZone = ds.mid(temp.length()+1, 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "d MMM yyyy");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    temp = ds.left(10);
-    timeZone = ds.mid(temp.length(), 3);
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "yyyy-MM-dd");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-
-    // @HACK(arhohryakov:2012.01.01):
-    // "dd MMM yy HH:mm:ss" format doesn/t parse automatically
-    // Reformat it to "dd MMM yyyy HH:mm:ss"
-    QString temp2;
-    temp2 = ds;  // save ds for output in case of error
-    if (70 < ds.mid(7, 2).toInt()) temp2.insert(7, "19");
-    else temp2.insert(7, "20");
-    temp = temp2.left(20);
-    timeZone = ds.mid(temp.length()+1-2, 3);  // "-2", cause 2 symbols inserted
-    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
-    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
-    if (dt.isValid()) return locale.toString(dt.addSecs(timeZone.toInt() * -3600), "yyyy-MM-ddTHH:mm:ss");
-  }
-
-  qDebug() << __LINE__ << "parseDate: error with" << dateString << urlString;
-  return QString();
-}
 
 /** @brief Apply user filters
  * @param feedId - Feed Id
@@ -1008,6 +893,7 @@ QString ParseObject::parseDate(const QString &dateString, const QString &urlStri
  *---------------------------------------------------------------------------*/
 void ParseObject::runUserFilter(int feedId, int filterId)
 {
+  TraceSpan span("runUserFilter", feedId);
   QSqlQuery q(db_);
   bool isAllFilters = true;
 
@@ -1245,6 +1131,7 @@ void ParseObject::runUserFilter(int feedId, int filterId)
       whereStr.append(qStr1).append(")");
     }
 
+    qCDebug(lcFilters) << "Filter" << filterId << "feed" << feedId << ":" << whereStr;
     if (q1.exec(QString("SELECT id, label FROM news").append(whereStr))) {
       QSqlQuery q2(db_);
       bool isPlaySound = false;
@@ -1302,6 +1189,7 @@ void ParseObject::runUserFilter(int feedId, int filterId)
 int ParseObject::recountFeedCounts(int feedId, const QString &feedUrl,
                                    const QString &updated, const QString &lastBuildDate)
 {
+  TraceSpan span("recountFeedCounts", feedId);
   QSqlQuery q(db_);
   q.setForwardOnly(true);
   QString qStr;
@@ -1322,20 +1210,17 @@ int ParseObject::recountFeedCounts(int feedId, const QString &feedUrl,
   int newNewsCount = 0;
 
   // Count all news (not marked Deleted)
-  qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-      arg(feedId);
+  qStr = kCountNewsQuery.arg(feedId);
   q.exec(qStr);
   if (q.first()) undeleteCount = q.value(0).toInt();
 
   // Count unread news
-  qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-      arg(feedId);
+  qStr = kCountUnreadNewsQuery.arg(feedId);
   q.exec(qStr);
   if (q.first()) unreadCount = q.value(0).toInt();
 
   // Count new news
-  qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-      arg(feedId);
+  qStr = kCountNewNewsQuery.arg(feedId);
   q.exec(qStr);
   if (q.first()) newNewsCount = q.value(0).toInt();
 
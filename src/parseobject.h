@@ -20,42 +20,12 @@
 
 #include <QtSql>
 #include <QDateTime>
-#include <QDomDocument>
+#include <QElapsedTimer>
 #include <QQueue>
 #include <QObject>
 #include <QUrl>
-#include <QMutex>
 
-struct FeedItemStruct {
-  QString title;
-  QString updated;
-  QString link;
-  QString linkBase;
-  QString language;
-  QString author;
-  QString authorUri;
-  QString authorEmail;
-  QString description;
-};
-
-struct NewsItemStruct {
-  QString id;
-  QString title;
-  QString updated;
-  QString link;
-  QString linkAlternate;
-  QString language;
-  QString author;
-  QString authorUri;
-  QString authorEmail;
-  QString description;
-  QString content;
-  QString category;
-  QString eUrl;
-  QString eType;
-  QString eLength;
-  QString comments;
-};
+#include "parseworker.h"
 
 struct FeedCountStruct{
   int feedId;
@@ -75,48 +45,86 @@ class ParseObject : public QObject
 {
   Q_OBJECT
 public:
-  explicit ParseObject(QObject *parent = 0);
+  explicit ParseObject(QObject *parent = 0,
+                       const QSqlDatabase &db = QSqlDatabase());
   ~ParseObject();
 
   void disconnectObjects();
+  void setWorkers(const QList<ParseWorker*> &workers);
 
 public slots:
   void parseXml(QByteArray data, int feedId,
-                QDateTime dtReply, QString codecName);
+                QDateTime dtReply, QString codecName,
+                QString etag = QString(), QString lastModified = QString(),
+                QString contentDigest = QString());
   void runUserFilter(int feedId, int filterId = -1);
 
 signals:
-  void signalReadyParse(const QByteArray &xml, const int &feedId,
-                        const QDateTime &dtReply, const QString &codecName);
   void signalFinishUpdate(int feedId, bool changed, int newCount, QString status);
   void feedCountsUpdate(FeedCountStruct counts);
   void signalPlaySound(const QString &soundPath);
   void signalAddColorList(int id, const QString &color);
+  void signalQueueFull(bool full);
 
 private slots:
   void getQueuedXml();
   void slotParse(const QByteArray &xmlData, const int &feedId,
-                 const QDateTime &dtReply, const QString &codecName);
+                 const QDateTime &dtReply, const QString &codecName,
+                 const QString &etag = QString(),
+                 const QString &lastModified = QString(),
+                 const QString &contentDigest = QString());
+  void slotParsed();
   void addAtomNewsIntoBase(NewsItemStruct *newsItem);
   void addRssNewsIntoBase(NewsItemStruct *newsItem);
 
 private:
-  void parseAtom(const QString &feedUrl, const QDomDocument &doc);
-  void parseRss(const QString &feedUrl, const QDomDocument &doc);
-  QString toPlainText(const QString &text);
-  QString fromPlainText(QString text);
-  QString getCommunity(const QDomNode &nodeContent);
-  QString parseDate(const QString &dateString, const QString &urlString);
+  void scheduleDispatch();
+  ParseWorker *freeWorker() const;
+  bool prepareJob(int feedId, ParseJob *job);
+  void updateQueueState();
+  QString spillData(const QByteArray &data);
+  QByteArray readSpilledData(const QString &fileName);
+  void writeParsedBatch(const ParsedFeed &batch);
+  void beginFeedWrite(const ParsedFeed &batch);
+  int finishFeedWrite(const ParsedFeed &batch);
+  void updateFeedInfo(const ParsedFeed &parsedFeed);
+  void addNewsIntoBatch(const NewsItemStruct &newsItem, bool read);
+  void flushNewsBatch();
+  void setItemHash(int row, qint64 hash);
+  void flushItemHashes();
   int recountFeedCounts(int feedId, const QString &feedUrl,
                         const QString &updated, const QString &lastBuildDate);
 
+  /** Fetched data waiting in parse queue */
+  struct QueuedXml
+  {
+    int feedId;
+    QByteArray data;
+    QDateTime dtReply;
+    QString codecName;
+    QString etag;
+    QString lastModified;
+    QString contentDigest;
+    QString spillFile;  // data is kept on disk if not empty
+  };
+
   QSqlDatabase db_;
-  QTimer *parseTimer_;
-  QMutex mutex_;
-  QQueue<int> idsQueue_;
-  QQueue<QByteArray> xmlsQueue_;
-  QQueue<QDateTime> dtReadyQueue_;
-  QQueue<QString> codecNameQueue_;
+  QQueue<QueuedXml> xmlQueue_;
+  bool dispatchPending_;
+  qint64 queueBytes_;     // queued data in memory
+  qint64 maxQueueBytes_;
+  bool queueFull_;
+  bool spillQueue_;
+  ParseWorker *localWorker_;
+  QList<ParseWorker*> workers_;
+  QHash<ParseWorker*, int> workerJobs_;  // jobs dispatched and not written yet
+  ParseWorker *writingWorker_;  // worker whose feed is partly written
+  int nextWorker_;
+
+  // Feed being written batch by batch
+  bool writeStarted_;
+  QString writeFeedUrl_;
+  int writtenItems_;
 
   int parseFeedId_;
   bool duplicateNewsMode_;
@@ -125,10 +133,23 @@ private:
   bool avoidedOldSingleNews_;
   QDate avoidedOldSingleNewsDate_;
 
-  QStringList guidList_;
-  QStringList linkList_;
+  // Stored news of parsed feed, indexes map a value to its rows
   QStringList titleList_;
   QStringList publishedList_;
+  QMultiHash<QString, int> guidIndex_;
+  QMultiHash<QString, int> linkIndex_;
+  QMultiHash<QString, int> titleIndex_;
+  QMultiHash<QString, int> publishedIndex_;
+  QList<int> newsIdList_;
+  QList<qint64> itemHashList_;
+  QVariantList itemHashBatch_[2];  // hashes and ids of news to update
+  QVector<QVariantList> newsBatch_;  // columns of news waiting for insert
+  int insertedNewsCount_;
+  qint64 insertNewsTime_;
+  qint64 totalInsertedNewsCount_;
+  qint64 totalInsertNewsTime_;
+  qint64 totalItemsCount_;
+  qint64 totalUnchangedItems_;
 
   QDateTime lastBuildDate_;
 
@@ -0,0 +1,752 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "parseworker.h"
+
+#include "database.h"
+#include "settings.h"
+#include "dateparser.h"
+#include "xmldecoder.h"
+#include "tracer.h"
+#include "logging.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringBuilder>
+#include <QTextDocumentFragment>
+#include <QThread>
+#include <QUrl>
+
+ParsedQueue::ParsedQueue()
+  : capacity_(0)
+  , closed_(false)
+{
+}
+
+void ParsedQueue::setCapacity(int capacity)
+{
+  QMutexLocker locker(&mutex_);
+  capacity_ = capacity;
+  notFull_.wakeAll();
+}
+
+/** @brief Put batch into queue, wait while queue is full
+ *----------------------------------------------------------------------------*/
+void ParsedQueue::put(const ParsedFeed &batch)
+{
+  QMutexLocker locker(&mutex_);
+  while (!closed_ && (capacity_ > 0) && (queue_.count() >= capacity_))
+    notFull_.wait(&mutex_);
+  if (closed_)
+    return;
+  queue_.enqueue(batch);
+}
+
+/** @brief Take next batch, false if queue is empty
+ *----------------------------------------------------------------------------*/
+bool ParsedQueue::take(ParsedFeed *batch)
+{
+  QMutexLocker locker(&mutex_);
+  if (queue_.isEmpty())
+    return false;
+  *batch = queue_.dequeue();
+  notFull_.wakeAll();
+  return true;
+}
+
+/** @brief Drop queued batches and release waiting worker
+ * @details Called before threads are stopped, writer doesn't take
+ *   batches any more
+ *----------------------------------------------------------------------------*/
+void ParsedQueue::close()
+{
+  QMutexLocker locker(&mutex_);
+  closed_ = true;
+  queue_.clear();
+  notFull_.wakeAll();
+}
+
+ParseWorker::ParseWorker(QObject *parent)
+  : QObject(parent)
+  , parsedFeed_(0)
+  , knownHashes_(0)
+  , parsedItems_(0)
+{
+  setObjectName("parseWorker_");
+
+  Settings settings;
+  itemsPerYield_ = settings.value("Settings/parseItemsPerYield", 20).toInt();
+  queue_.setCapacity(settings.value("Settings/parsedQueueBatches", 4).toInt());
+}
+
+void ParseWorker::parse(const ParseJob &job)
+{
+  parseFeed(job);
+}
+
+/** @brief Decode and parse xml-data into feed properties and news list
+ *
+ * News are put into queue in batches of NEWS_BATCH_SIZE while parsing,
+ * last batch is put when data is parsed. If reader detects same codec
+ * as decoder it decodes data block by block itself, so decoded document
+ * isn't held in memory as a whole
+ *----------------------------------------------------------------------------*/
+void ParseWorker::parseFeed(const ParseJob &job)
+{
+  TraceSpan parseSpan("parse", job.feedId);
+
+  ParsedFeed parsedFeed;
+  parsedFeed.feedId = job.feedId;
+  parsedFeed.feedUrl = job.feedUrl;
+  parsedFeed.dtReply = job.dtReply;
+  parsedFeed.etag = job.etag;
+  parsedFeed.lastModified = job.lastModified;
+  parsedFeed.contentDigest = job.contentDigest;
+  parsedFeed.unchangedItems = 0;
+  parsedFeed.hasError = false;
+  parsedFeed.last = false;
+  parsedFeed_ = &parsedFeed;
+  knownHashes_ = &job.knownHashes;
+  parsedItems_ = 0;
+  QElapsedTimer parseTime;
+  parseTime.start();
+
+  QXmlStreamReader xml;
+  xml.setNamespaceProcessing(false);
+  QBuffer buffer;
+  if (XmlDecoder::isReaderCodec(job.data, job.codecName)) {
+    buffer.setData(job.data);
+    buffer.open(QIODevice::ReadOnly);
+    xml.setDevice(&buffer);
+  } else {
+    TraceSpan decodeSpan("decode", job.feedId);
+    xml.addData(XmlDecoder::decode(job.data, job.codecName));
+  }
+
+  while (!xml.atEnd() && !xml.isStartElement())
+    xml.readNext();
+
+  if (xml.isStartElement()) {
+    parsedFeed.feedType = xml.qualifiedName().toString();
+    qCDebug(lcParse) << "Feed type: " << parsedFeed.feedType;
+  }
+
+  if (parsedFeed.feedType == "feed") {
+    parseAtom(job.feedUrl, xml);
+  } else if ((parsedFeed.feedType == "rss") || (parsedFeed.feedType == "rdf:RDF")) {
+    parseRss(job.feedUrl, xml);
+  } else {
+    parsedFeed.hasError = true;
+  }
+
+  if (xml.hasError()) {
+    parsedFeed.hasError = true;
+    qWarning() << QString("Parse data error (2): url %1, id %2, line %3, column %4: %5").
+                  arg(job.feedUrl).arg(job.feedId).
+                  arg(xml.lineNumber()).arg(xml.columnNumber()).arg(xml.errorString());
+  }
+
+  qCDebug(lcParse) << QString("Parsed %1 items in %2 ms, %3 unchanged items skipped").
+              arg(parsedItems_).arg(parseTime.elapsed()).arg(parsedFeed.unchangedItems);
+  putBatch(true);
+  parsedFeed_ = 0;
+  knownHashes_ = 0;
+}
+
+/** @brief Add news to batch, full batch is put into queue
+ *----------------------------------------------------------------------------*/
+void ParseWorker::addNews(const NewsItemStruct &newsItem)
+{
+  parsedFeed_->newsList.append(newsItem);
+  if (parsedFeed_->newsList.count() >= NEWS_BATCH_SIZE)
+    putBatch(false);
+}
+
+/** @brief Put batch into queue and notify writer
+ * @details Feed properties and count of unchanged items are kept for
+ *   next batches, so last batch carries final values
+ *----------------------------------------------------------------------------*/
+void ParseWorker::putBatch(bool last)
+{
+  parsedFeed_->last = last;
+  queue_.put(*parsedFeed_);
+  parsedFeed_->newsList.clear();
+  emit parsed();
+}
+
+/** @brief Let other threads run after every itemsPerYield_ parsed items
+ *
+ * Parse thread has low priority already, so yielding is enough to keep
+ * GUI responsive without capping throughput. Zero disables yielding
+ *----------------------------------------------------------------------------*/
+void ParseWorker::yieldParsing()
+{
+  ++parsedItems_;
+  if ((itemsPerYield_ > 0) && (parsedItems_ % itemsPerYield_ == 0))
+    QThread::yieldCurrentThread();
+}
+
+/** @brief Parse Atom feed
+ *
+ * Reader is positioned at root element. Feed-level elements are collected
+ * into one element, entries are read and stored one at a time
+ *----------------------------------------------------------------------------*/
+void ParseWorker::parseAtom(const QString &feedUrl, QXmlStreamReader &xml)
+{
+  XmlElement rootElem(xml.qualifiedName().toString(), xml.attributes());
+  FeedItemStruct feedItem;
+  bool feedLinkParsed = false;
+
+  while (xml.readNextStartElement()) {
+    if (xml.qualifiedName() == QLatin1String("entry")) {
+      if (!feedLinkParsed) {
+        parseAtomFeedLink(feedUrl, rootElem, &feedItem);
+        feedLinkParsed = true;
+      }
+      parseAtomEntry(feedUrl, XmlElement::read(xml), feedItem);
+    } else {
+      rootElem.appendChild(XmlElement::read(xml));
+    }
+  }
+  if (!feedLinkParsed)
+    parseAtomFeedLink(feedUrl, rootElem, &feedItem);
+
+  feedItem.title = toPlainText(rootElem.namedItem("title").text());
+  feedItem.description = rootElem.namedItem("subtitle").text();
+  feedItem.updated = rootElem.namedItem("updated").text();
+  feedItem.updated = parseDate(feedItem.updated, feedUrl);
+  XmlElement authorElem = rootElem.namedItem("author");
+  if (!authorElem.isNull()) {
+    feedItem.author = toPlainText(authorElem.namedItem("name").text());
+    if (feedItem.author.isEmpty()) feedItem.author = toPlainText(authorElem.text());
+    feedItem.authorUri = authorElem.namedItem("uri").text();
+    feedItem.authorEmail = authorElem.namedItem("email").text();
+  }
+  feedItem.language = rootElem.namedItem("language").text();
+
+  parsedFeed_->feedItem = feedItem;
+}
+
+/** @brief Feed link and base of relative news links from Atom feed element
+ *----------------------------------------------------------------------------*/
+void ParseWorker::parseAtomFeedLink(const QString &feedUrl, const XmlElement &rootElem,
+                                    FeedItemStruct *feedItem)
+{
+  feedItem->linkBase = rootElem.attribute("xml:base");
+  QList<XmlElement> linksList = rootElem.elementsByTagName("link");
+  for (int j = 0; j < linksList.size(); j++) {
+    if (linksList.at(j).attribute("rel") == "alternate") {
+      feedItem->link = linksList.at(j).attribute("href");
+      break;
+    }
+  }
+  if (feedItem->link.isEmpty()) {
+    for (int j = 0; j < linksList.size(); j++) {
+        if (!(linksList.at(j).attribute("rel") == "self")) {
+          feedItem->link = linksList.at(j).attribute("href");
+          break;
+        }
+    }
+  }
+
+  if (QUrl(feedItem->link).host().isEmpty() || (QUrl(feedItem->link).host().indexOf('.')) == -1) {
+    if (!feedItem->linkBase.isEmpty() && !QUrl(feedItem->linkBase).host().isEmpty())
+      feedItem->link = QUrl(feedItem->linkBase).scheme() %  "://" % QUrl(feedItem->linkBase).host();
+    else
+      feedItem->link = QUrl(feedUrl).scheme() %  "://" % QUrl(feedUrl).host();
+  }
+  if (feedItem->linkBase.isEmpty() && !QUrl(feedItem->link).host().isEmpty())
+    feedItem->linkBase = QUrl(feedItem->link).scheme() %  "://" % QUrl(feedItem->link).host();
+  if (QUrl(feedItem->link).host().isEmpty())
+    feedItem->link = feedItem->linkBase + feedItem->link;
+  feedItem->link = toPlainText(feedItem->link);
+  QUrl url = QUrl(feedItem->link);
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem->link = url.toString();
+}
+
+void ParseWorker::parseAtomEntry(const QString &feedUrl, const XmlElement &entryElem,
+                                 const FeedItemStruct &feedItem)
+{
+  NewsItemStruct newsItem;
+  newsItem.itemHash = itemHash(entryElem);
+  if (isKnownItem(newsItem.itemHash))
+    return;
+
+  newsItem.id = entryElem.namedItem("id").text();
+  newsItem.title = toPlainText(entryElem.namedItem("title").text());
+  newsItem.updated = entryElem.namedItem("published").text();
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = entryElem.namedItem("updated").text();
+  newsItem.updated = parseDate(newsItem.updated, feedUrl);
+  XmlElement authorElem = entryElem.namedItem("author");
+  if (!authorElem.isNull()) {
+    newsItem.author = toPlainText(authorElem.namedItem("name").text());
+    if (newsItem.author.isEmpty()) newsItem.author = toPlainText(authorElem.text());
+    newsItem.authorUri = authorElem.namedItem("uri").text();
+    newsItem.authorEmail = authorElem.namedItem("email").text();
+  }
+
+  newsItem.description = entryElem.namedItem("summary").text();
+  XmlElement nodeSummary = entryElem.namedItem("summary");
+  if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
+    newsItem.description = nodeSummary.toString();
+  }
+  XmlElement nodeContent = entryElem.namedItem("content");
+  if (nodeContent.attribute("type") == "xhtml") {
+    newsItem.content = nodeContent.toString();
+  } else {
+    newsItem.content = nodeContent.text();
+  }
+  QString imgUrl = entryElem.namedItem("media:thumbnail").attribute("url");
+  QString community = getCommunity(entryElem.namedItem("media:community"));
+  nodeContent = entryElem.namedItem("media:group");
+  if (!nodeContent.isNull()) {
+    QString description = nodeContent.namedItem("media:description").text();
+    if (description.length() > newsItem.content.length())
+      newsItem.content = description;
+    newsItem.content = fromPlainText(newsItem.content);
+    if (imgUrl.isEmpty())
+      imgUrl = nodeContent.namedItem("media:thumbnail").attribute("url");
+    if (community.isEmpty())
+      community = getCommunity(nodeContent.namedItem("media:community"));
+  }
+  if (!(newsItem.content.isEmpty() ||
+        (newsItem.description.length() > newsItem.content.length()))) {
+    newsItem.description = newsItem.content;
+  }
+  newsItem.content.clear();
+  if (!imgUrl.isEmpty()) {
+    newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+    newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+  }
+  if (!community.isEmpty())
+    newsItem.description += community;
+
+  QList<XmlElement> categoryElem = entryElem.elementsByTagName("category");
+  for (int j = 0; j < categoryElem.size(); j++) {
+    if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+    QString category = categoryElem.at(j).attribute("label");
+    if (category.isEmpty())
+      category = categoryElem.at(j).attribute("term");
+    newsItem.category.append(toPlainText(category));
+  }
+  XmlElement enclosureElem = entryElem.namedItem("enclosure");
+  newsItem.eUrl = enclosureElem.attribute("url");
+  newsItem.eType = enclosureElem.attribute("type");
+  newsItem.eLength = enclosureElem.attribute("length");
+  QList<XmlElement> linksList = entryElem.elementsByTagName("link");
+  for (int j = 0; j < linksList.size(); j++) {
+    if (linksList.at(j).attribute("type") == "text/html") {
+      if (linksList.at(j).attribute("rel") == "self")
+        newsItem.link = linksList.at(j).attribute("href");
+      if (linksList.at(j).attribute("rel") == "alternate")
+        newsItem.linkAlternate = linksList.at(j).attribute("href");
+      if (linksList.at(j).attribute("rel") == "replies")
+        newsItem.comments = linksList.at(j).attribute("href");
+    } else if (newsItem.linkAlternate.isEmpty()) {
+      if (linksList.at(j).attribute("rel") == "alternate")
+        newsItem.linkAlternate = linksList.at(j).attribute("href");
+    }
+  }
+  for (int j = 0; j < linksList.size(); j++) {
+    if (newsItem.linkAlternate.isEmpty()) {
+      if (!(linksList.at(j).attribute("rel") == "self")) {
+        newsItem.linkAlternate = linksList.at(j).attribute("href");
+        break;
+      }
+    }
+  }
+
+  if (!newsItem.link.isEmpty() && QUrl(newsItem.link).host().isEmpty())
+    newsItem.link = feedItem.linkBase + newsItem.link;
+  newsItem.link = toPlainText(newsItem.link);
+  if (!newsItem.linkAlternate.isEmpty() && QUrl(newsItem.linkAlternate).host().isEmpty())
+    newsItem.linkAlternate = feedItem.linkBase + newsItem.linkAlternate;
+  newsItem.linkAlternate = toPlainText(newsItem.linkAlternate);
+  if (newsItem.link.isEmpty()) {
+    newsItem.link = newsItem.linkAlternate;
+    newsItem.linkAlternate.clear();
+  }
+  QUrl url = QUrl(newsItem.link);
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  newsItem.link = url.toString();
+
+  yieldParsing();
+  addNews(newsItem);
+}
+
+/** @brief Parse RSS and RDF feed
+ *
+ * Reader is positioned at root element. Items are read and stored one at
+ * a time, other channel elements are collected for feed properties
+ *----------------------------------------------------------------------------*/
+void ParseWorker::parseRss(const QString &feedUrl, QXmlStreamReader &xml)
+{
+  XmlElement channel;
+
+  while (xml.readNextStartElement()) {
+    QString tagName = xml.qualifiedName().toString();
+    if ((tagName == "channel") || (tagName == "rss:channel")) {
+      XmlElement channelElem(tagName, xml.attributes());
+      while (xml.readNextStartElement()) {
+        if ((xml.qualifiedName() == QLatin1String("item")) ||
+            (xml.qualifiedName() == QLatin1String("rss:item"))) {
+          parseRssItem(feedUrl, XmlElement::read(xml));
+        } else {
+          channelElem.appendChild(XmlElement::read(xml));
+        }
+      }
+      if (channel.isNull())
+        channel = channelElem;
+    } else if ((tagName == "item") || (tagName == "rss:item")) {
+      parseRssItem(feedUrl, XmlElement::read(xml));
+    } else {
+      xml.skipCurrentElement();
+    }
+  }
+
+  FeedItemStruct feedItem;
+
+  feedItem.title = toPlainText(channel.namedItem("title").text());
+  if (feedItem.title.isEmpty())
+    feedItem.title = toPlainText(channel.namedItem("rss:title").text());
+  feedItem.description = channel.namedItem("description").text();
+  if (feedItem.description.isEmpty())
+    feedItem.description = toPlainText(channel.namedItem("rss:description").text());
+  feedItem.link = toPlainText(channel.namedItem("link").text());
+  if (feedItem.link.isEmpty())
+    feedItem.link = toPlainText(channel.namedItem("rss:link").text());
+  QUrl url = QUrl(feedItem.link);
+  if (url.host().isEmpty())
+    url.setHost(QUrl(feedUrl).host());
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  feedItem.link = url.toString();
+
+  feedItem.updated = channel.namedItem("pubDate").text();
+  if (feedItem.updated.isEmpty())
+    feedItem.updated = channel.namedItem("pubdate").text();
+  feedItem.updated = parseDate(feedItem.updated, feedUrl);
+  feedItem.author = toPlainText(channel.namedItem("author").text());
+  feedItem.language = channel.namedItem("language").text();
+  if (feedItem.language.isEmpty())
+    feedItem.language = channel.namedItem("dc:language").text();
+
+  parsedFeed_->feedItem = feedItem;
+}
+
+void ParseWorker::parseRssItem(const QString &feedUrl, const XmlElement &itemElem)
+{
+  NewsItemStruct newsItem;
+  newsItem.itemHash = itemHash(itemElem);
+  if (isKnownItem(newsItem.itemHash))
+    return;
+
+  newsItem.id = itemElem.namedItem("guid").text();
+  newsItem.title = toPlainText(itemElem.namedItem("title").text());
+  if (newsItem.title.isEmpty())
+    newsItem.title = toPlainText(itemElem.namedItem("rss:title").text());
+  newsItem.updated = itemElem.namedItem("pubDate").text();
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = itemElem.namedItem("pubdate").text();
+  if (newsItem.updated.isEmpty())
+    newsItem.updated = itemElem.namedItem("dc:date").text();
+  newsItem.updated = parseDate(newsItem.updated, feedUrl);
+  newsItem.author = toPlainText(itemElem.namedItem("author").text());
+  if (newsItem.author.isEmpty())
+    newsItem.author = toPlainText(itemElem.namedItem("dc:creator").text());
+  newsItem.link = toPlainText(itemElem.namedItem("link").text());
+  if (newsItem.link.isEmpty()) {
+      newsItem.link = toPlainText(itemElem.namedItem("rss:link").text());
+      if (newsItem.link.isEmpty()) {
+          if (itemElem.namedItem("guid").attribute("isPermaLink") == "true")
+              newsItem.link = newsItem.id;
+      }
+  }
+  QUrl url = QUrl(newsItem.link);
+  if (url.host().isEmpty())
+    url.setHost(QUrl(feedUrl).host());
+  if (url.scheme().isEmpty())
+    url.setScheme(QUrl(feedUrl).scheme());
+  newsItem.link = url.toString();
+
+  newsItem.description = itemElem.namedItem("description").text();
+  XmlElement nodeSummary = itemElem.namedItem("description");
+  if (!nodeSummary.isNull() && newsItem.description.isEmpty()) {
+    newsItem.description = nodeSummary.toString();
+  }
+  newsItem.content = itemElem.namedItem("content:encoded").text();
+  XmlElement nodeContent = itemElem.namedItem("content:encoded");
+  if (!nodeContent.isNull() && newsItem.content.isEmpty()) {
+    newsItem.content = nodeContent.toString();
+  }
+  QString imgUrl = itemElem.namedItem("media:thumbnail").attribute("url");
+  QString community = getCommunity(itemElem.namedItem("media:community"));
+  nodeContent = itemElem.namedItem("media:group");
+  if (!nodeContent.isNull()) {
+    QString description = nodeContent.namedItem("media:description").text();
+    if (description.length() > newsItem.content.length())
+      newsItem.content = description;
+    newsItem.content = fromPlainText(newsItem.content);
+    if (imgUrl.isEmpty())
+      imgUrl = nodeContent.namedItem("media:thumbnail").attribute("url");
+    if (community.isEmpty())
+      community = getCommunity(nodeContent.namedItem("media:community"));
+  }
+  if (!(newsItem.content.isEmpty() ||
+        (newsItem.description.length() > newsItem.content.length()))) {
+    newsItem.description = newsItem.content;
+  }
+  newsItem.content.clear();
+  if (!imgUrl.isEmpty()) {
+    newsItem.description = "<p class=\"description\">" + newsItem.description + "</p>";
+    newsItem.description += "<img src=\"" + imgUrl + "\" alt=\"image\"/>";
+  }
+  if (!community.isEmpty())
+    newsItem.description += community;
+
+  QList<XmlElement> categoryElem = itemElem.elementsByTagName("category");
+  for (int j = 0; j < categoryElem.size(); j++) {
+    if (!newsItem.category.isEmpty()) newsItem.category.append(", ");
+    newsItem.category.append(toPlainText(categoryElem.at(j).text()));
+  }
+  newsItem.comments = itemElem.namedItem("comments").text();
+  XmlElement enclosureElem = itemElem.namedItem("enclosure");
+  newsItem.eUrl = enclosureElem.attribute("url");
+  newsItem.eType = enclosureElem.attribute("type");
+  newsItem.eLength = enclosureElem.attribute("length");
+
+  if (newsItem.title.isEmpty()) {
+    newsItem.title = toPlainText(newsItem.description);
+    if (newsItem.title.size() > 50) {
+      newsItem.title.resize(50);
+      newsItem.title = newsItem.title % "...";
+    }
+  }
+
+  yieldParsing();
+  addNews(newsItem);
+}
+
+/** @brief Hash of raw identity fields of item
+ *
+ * Fields are taken as is from data, so item republished without changes
+ * is recognized before any conversion of it
+ *----------------------------------------------------------------------------*/
+qint64 ParseWorker::itemHash(const XmlElement &itemElem)
+{
+  static const char *identityFields[] = {
+    "id", "guid", "link", "rss:link", "published", "updated",
+    "pubDate", "pubdate", "dc:date", "title", "rss:title", 0
+  };
+
+  QString identity;
+  for (int i = 0; identityFields[i]; ++i) {
+    identity.append(itemElem.namedItem(identityFields[i]).text());
+    identity.append('\n');
+  }
+  return Database::hash(identity.toUtf8());
+}
+
+/** @brief Item was stored in base already, count it as skipped
+ *----------------------------------------------------------------------------*/
+bool ParseWorker::isKnownItem(qint64 hash)
+{
+  if (!knownHashes_ || !knownHashes_->contains(hash))
+    return false;
+
+  parsedFeed_->unchangedItems++;
+  return true;
+}
+
+QString ParseWorker::toPlainText(const QString &text)
+{
+  return QTextDocumentFragment::fromHtml(text).toPlainText().simplified();
+}
+
+QString ParseWorker::fromPlainText(QString text)
+{
+  text = text.replace("\r\n", "<br>");
+  text = text.replace("\n", "<br>");
+  return text;
+}
+
+QString ParseWorker::getCommunity(const XmlElement &nodeContent)
+{
+  QString community;
+  if (!nodeContent.isNull()) {
+    QString count = nodeContent.namedItem("media:starRating").attribute("count");
+    QString average = nodeContent.namedItem("media:starRating").attribute("average");
+    QString min = nodeContent.namedItem("media:starRating").attribute("min");
+    QString max = nodeContent.namedItem("media:starRating").attribute("max");
+    QString views = nodeContent.namedItem("media:statistics").attribute("views");
+    if (!count.isEmpty())
+      community = QString("Count: %1, average: %2, min: %3, max: %4<br>").
+          arg(count).arg(average).arg(min).arg(max);
+    if (!views.isEmpty())
+      community += QString("Views: %1").arg(views);
+    if (!community.isEmpty())
+      community = "<p><i>" + community + "</i></p>";
+  }
+  return community;
+}
+
+/** @brief Date/time string parsing
+ *
+ * Format that parsed last date of the feed is tried first, so usually
+ * one attempt is enough
+ *----------------------------------------------------------------------------*/
+QString ParseWorker::parseDate(const QString &dateString, const QString &urlString)
+{
+  if (dateString.isEmpty()) return QString();
+
+  QString ds = dateString.simplified();
+  int lastFormat = dateFormats_.value(urlString, DateParser::IsoFormat);
+  QDateTime dt = parseDateFormat(ds, lastFormat);
+  for (int format = DateParser::IsoFormat;
+       !dt.isValid() && (format <= DateParser::LocaleFormat); ++format) {
+    if (format == lastFormat) continue;
+    dt = parseDateFormat(ds, format);
+    if (dt.isValid())
+      dateFormats_.insert(urlString, format);
+  }
+
+  if (dt.isValid())
+    return QLocale::c().toString(dt, "yyyy-MM-ddTHH:mm:ss");
+
+  qCDebug(lcParse) << __LINE__ << "parseDate: error with" << dateString << urlString;
+  return QString();
+}
+
+QDateTime ParseWorker::parseDateFormat(const QString &dateString, int format)
+{
+  switch (format) {
+  case DateParser::IsoFormat:
+    return DateParser::fromIso(dateString);
+  case DateParser::RfcFormat:
+    return DateParser::fromRfc822(dateString);
+  default:
+    return parseDateLocale(dateString);
+  }
+}
+
+/** @brief Date/time parsing with C and system locale formats
+ *
+ * Fallback for dates that are neither RFC 822 nor ISO 8601
+ *----------------------------------------------------------------------------*/
+QDateTime ParseWorker::parseDateLocale(const QString &dateString)
+{
+  QDateTime dt;
+  QString temp;
+  QString timeZone;
+
+  QDateTime dtLocalTime = QDateTime::currentDateTime();
+  QDateTime dtUTC = QDateTime(dtLocalTime.date(), dtLocalTime.time(), Qt::UTC);
+  int nTimeShift = dtLocalTime.secsTo(dtUTC)/3600;
+
+  QString ds = dateString;
+  QLocale locale(QLocale::C);
+
+  if (ds.indexOf(',') != -1) {
+    ds = ds.remove(0, ds.indexOf(',')+1).simplified();
+  }
+
+  for (int i = 0; i < 2; i++, locale = QLocale::system()) {
+    temp     = ds.left(23);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss.z");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp     = ds.left(19);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-ddTHH:mm:ss");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(23);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss.z");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(19);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd HH:mm:ss");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(20);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.contains("EDT"))
+      timeZone="-4";
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(19);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "d MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(11);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(10);
+    timeZone = ds.mid(temp.length()+1, 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "d MMM yyyy");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    temp = ds.left(10);
+    timeZone = ds.mid(temp.length(), 3);
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "yyyy-MM-dd");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+
+    // @HACK(arhohryakov:2012.01.01):
+    // "dd MMM yy HH:mm:ss" format doesn/t parse automatically
+    // Reformat it to "dd MMM yyyy HH:mm:ss"
+    QString temp2;
+    temp2 = ds;  // save ds for output in case of error
+    if (70 < ds.mid(7, 2).toInt()) temp2.insert(7, "19");
+    else temp2.insert(7, "20");
+    temp = temp2.left(20);
+    timeZone = ds.mid(temp.length()+1-2, 3);  // "-2", cause 2 symbols inserted
+    if (timeZone.isEmpty()) timeZone = QString::number(nTimeShift);
+    dt = locale.toDateTime(temp, "dd MMM yyyy HH:mm:ss");
+    if (dt.isValid()) return toUtcDateTime(dt, timeZone);
+  }
+
+  return QDateTime();
+}
+
+/** @brief Shift date/time by zone hours and mark it as UTC
+ *----------------------------------------------------------------------------*/
+QDateTime ParseWorker::toUtcDateTime(const QDateTime &dateTime, const QString &timeZone)
+{
+  QDateTime dt(dateTime.date(), dateTime.time(), Qt::UTC);
+  return dt.addSecs(timeZone.toInt() * -3600);
+}
@@ -0,0 +1,175 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef PARSEWORKER_H
+#define PARSEWORKER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QWaitCondition>
+#include <QXmlStreamReader>
+
+#include "xmlelement.h"
+
+#define NEWS_BATCH_SIZE 100
+
+struct FeedItemStruct {
+  QString title;
+  QString updated;
+  QString link;
+  QString linkBase;
+  QString language;
+  QString author;
+  QString authorUri;
+  QString authorEmail;
+  QString description;
+};
+
+struct NewsItemStruct {
+  QString id;
+  QString title;
+  QString updated;
+  QString link;
+  QString linkAlternate;
+  QString language;
+  QString author;
+  QString authorUri;
+  QString authorEmail;
+  QString description;
+  QString content;
+  QString category;
+  QString eUrl;
+  QString eType;
+  QString eLength;
+  QString comments;
+  qint64 itemHash;
+};
+
+/** Fetched data of feed waiting for parse worker */
+struct ParseJob {
+  int feedId;
+  QString feedUrl;
+  QByteArray data;
+  QDateTime dtReply;
+  QString codecName;
+  QString etag;          // validators of reply, saved with parsed news
+  QString lastModified;
+  QString contentDigest;
+  QSet<qint64> knownHashes;  // items of feed stored in base
+};
+
+/** Batch of news parsed from data of feed, ready to be written.
+ *  Last batch of feed carries feed properties too */
+struct ParsedFeed {
+  int feedId;
+  QString feedUrl;
+  QDateTime dtReply;
+  QString etag;
+  QString lastModified;
+  QString contentDigest;
+  QString feedType;
+  FeedItemStruct feedItem;
+  QList<NewsItemStruct> newsList;  // at most NEWS_BATCH_SIZE news
+  int unchangedItems;  // items skipped by known hash
+  bool hasError;       // data isn't a complete feed
+  bool last;
+};
+
+Q_DECLARE_METATYPE(ParseJob)
+
+/** @brief Bounded queue of parsed batches from one worker to writer
+ *
+ * Worker waits in put() while queue is full, so parsing doesn't run ahead
+ * of database writes. Closed queue drops batches and doesn't wait
+ *----------------------------------------------------------------------------*/
+class ParsedQueue
+{
+public:
+  ParsedQueue();
+
+  void setCapacity(int capacity);
+  void put(const ParsedFeed &batch);
+  bool take(ParsedFeed *batch);
+  void close();
+
+private:
+  QMutex mutex_;
+  QWaitCondition notFull_;
+  QQueue<ParsedFeed> queue_;
+  int capacity_;  // zero is unbounded
+  bool closed_;
+
+};
+
+/** @brief Decode and parse of feed data without database access
+ *
+ * Several workers run in own threads. News are put into queue of worker
+ * in batches as they are parsed and written into database by ParseObject
+ *----------------------------------------------------------------------------*/
+class ParseWorker : public QObject
+{
+  Q_OBJECT
+public:
+  explicit ParseWorker(QObject *parent = 0);
+
+  void parseFeed(const ParseJob &job);
+  bool takeParsed(ParsedFeed *batch) { return queue_.take(batch); }
+  void closeQueue() { queue_.close(); }
+
+public slots:
+  void parse(const ParseJob &job);
+
+signals:
+  void parsed();  // batch is put into queue
+
+private:
+  void addNews(const NewsItemStruct &newsItem);
+  void putBatch(bool last);
+  void parseAtom(const QString &feedUrl, QXmlStreamReader &xml);
+  void parseAtomFeedLink(const QString &feedUrl, const XmlElement &rootElem,
+                         FeedItemStruct *feedItem);
+  void parseAtomEntry(const QString &feedUrl, const XmlElement &entryElem,
+                      const FeedItemStruct &feedItem);
+  void parseRss(const QString &feedUrl, QXmlStreamReader &xml);
+  void parseRssItem(const QString &feedUrl, const XmlElement &itemElem);
+  qint64 itemHash(const XmlElement &itemElem);
+  bool isKnownItem(qint64 hash);
+  QString toPlainText(const QString &text);
+  QString fromPlainText(QString text);
+  QString getCommunity(const XmlElement &nodeContent);
+  QString parseDate(const QString &dateString, const QString &urlString);
+  QDateTime parseDateFormat(const QString &dateString, int format);
+  QDateTime parseDateLocale(const QString &dateString);
+  QDateTime toUtcDateTime(const QDateTime &dateTime, const QString &timeZone);
+  void yieldParsing();
+
+  ParsedQueue queue_;
+  ParsedFeed *parsedFeed_;
+  const QSet<qint64> *knownHashes_;
+  int itemsPerYield_;
+  int parsedItems_;
+  QHash<QString, int> dateFormats_;  // last successful date format of feed
+
+};
+
+#endif // PARSEWORKER_H
@@ -16,15 +16,20 @@
 * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 * ============================================================ */
 #include "requestfeed.h"
+#include "contentdecoder.h"
+#include "retrypolicy.h"
 #include "VersionNo.h"
 #include "mainapplication.h"
 #include "globals.h"
+#include "logging.h"
+#include "tracer.h"
 
 #include <QDebug>
 #include <QtSql>
 #include <qzregexp.h>
 
-#define REPLY_MAX_COUNT 10
+#define HOST_MAX_REQUESTS 4
+#define HOST_THROTTLED_DELAY 1000
 
 RequestFeed::RequestFeed(int timeoutRequest, int numberRequests,
                          int numberRepeats, QObject *parent)
@@ -33,29 +38,36 @@ RequestFeed::RequestFeed(int timeoutRequest, int numberRequests,
   , timeoutRequest_(timeoutRequest)
   , numberRequests_(numberRequests)
   , numberRepeats_(numberRepeats)
+  , queuedCount_(0)
+  , activeCount_(0)
+  , paused_(false)
 {
   setObjectName("requestFeed_");
 
-  timeout_ = new QTimer(this);
-  timeout_->setInterval(1000);
-  connect(timeout_, SIGNAL(timeout()), this, SLOT(slotRequestTimeout()));
+  clock_.start();
+
+  timeoutQueue_ = new TimeoutQueue(this);
+  connect(timeoutQueue_, SIGNAL(timeout(QNetworkReply*)),
+          this, SLOT(slotRequestTimeout(QNetworkReply*)));
 
   getUrlTimer_ = new QTimer(this);
   getUrlTimer_->setSingleShot(true);
   getUrlTimer_->setInterval(50);
   connect(getUrlTimer_, SIGNAL(timeout()), this, SLOT(getQueuedUrl()));
 
-  connect(this, SIGNAL(signalHead(QUrl,int,QString,QDateTime,int)),
-          SLOT(slotHead(QUrl,int,QString,QDateTime,int)),
-          Qt::QueuedConnection);
-  connect(this, SIGNAL(signalGet(QUrl,int,QString,QDateTime,int)),
-          SLOT(slotGet(QUrl,int,QString,QDateTime,int)),
+  retryTimer_ = new QTimer(this);
+  retryTimer_->setSingleShot(true);
+  connect(retryTimer_, SIGNAL(timeout()), this, SLOT(slotRetry()));
+
+  connect(this, SIGNAL(signalGet(QUrl,int,QString,QString,QString,int)),
+          SLOT(slotGet(QUrl,int,QString,QString,QString,int)),
           Qt::QueuedConnection);
 }
 
 RequestFeed::~RequestFeed()
 {
-
+  foreach (const RequestState &state, requests_)
+    delete state.decoder;
 }
 
 void RequestFeed::disconnectObjects()
@@ -65,10 +77,12 @@ void RequestFeed::disconnectObjects()
     networkManager_->disconnect(networkManager_);
 }
 
-/** @brief Put URL in request queue
+/** @brief Put URL in request queue of its host
+ * @param etag - ETag validator saved from the previous reply
+ * @param lastModified - Last-Modified validator saved from the previous reply
  *----------------------------------------------------------------------------*/
-void RequestFeed::requestUrl(int id, QString urlString,
-                              QDateTime date, QString userInfo)
+void RequestFeed::requestUrl(int id, QString urlString, QString etag,
+                             QString lastModified, QString userInfo)
 {
   if (!networkManager_) {
     networkManager_ = new NetworkManager(true, this);
@@ -76,125 +90,249 @@ void RequestFeed::requestUrl(int id, QString urlString,
             this, SLOT(finished(QNetworkReply*)));
   }
 
-  if (!timeout_->isActive())
-    timeout_->start();
+  QueuedFeed feed;
+  feed.id = id;
+  feed.url = urlString;
+  feed.etag = etag;
+  feed.lastModified = lastModified;
+  feed.userInfo = userInfo;
 
-  idsQueue_.enqueue(id);
-  feedsQueue_.enqueue(urlString);
-  dateQueue_.enqueue(date);
-  userInfo_.enqueue(userInfo);
+  QString host = QUrl(urlString).host();
+  hosts_[host].feedsQueue.enqueue(feed);
+  queuedCount_++;
+  makeHostReady(host);
 
   if (!getUrlTimer_->isActive())
-    getUrlTimer_->start();
+    getUrlTimer_->start(50);
 
-  qDebug() << "requestUrl() <<" << urlString << "countQueue=" << feedsQueue_.count();
+  qCDebug(lcNetwork) << "requestUrl() <<" << urlString << "countQueue=" << queuedCount_;
 }
 
 void RequestFeed::stopRequest()
 {
-  while (!feedsQueue_.isEmpty()) {
-    int feedId = idsQueue_.dequeue();
-    QString feedUrl = feedsQueue_.dequeue();
-    dateQueue_.clear();
-    userInfo_.clear();
+  QHash<QString, HostState>::iterator it = hosts_.begin();
+  for (; it != hosts_.end(); ++it) {
+    while (!it->feedsQueue.isEmpty()) {
+      QueuedFeed feed = it->feedsQueue.dequeue();
+      queuedCount_--;
 
-    emit getUrlDone(feedsQueue_.count(), feedId, feedUrl);
+      emit getUrlDone(queuedCount_, feed.id, feed.url);
+    }
   }
+
+  // Repeats waiting for backoff delay are not sent anymore
+  retryTimer_->stop();
+  QMultiMap<qint64, RetryRequest> retries = retries_;
+  retries_.clear();
+  foreach (const RetryRequest &retry, retries) {
+    emit getUrlDone(queuedCount_, retry.feedId, retry.feedUrl);
+    releaseHost(retry.feedUrl);
+  }
+}
+
+/** @brief Send all requests to local stand-in server instead of feed hosts
+ * @details Hosts of feeds are still used to limit connections per host
+ *----------------------------------------------------------------------------*/
+void RequestFeed::setStandInUrl(const QString &url)
+{
+  standInUrl_ = url;
+}
+
+/** @brief Stop or resume sending new requests, requests in flight go on
+ *----------------------------------------------------------------------------*/
+void RequestFeed::setPaused(bool paused)
+{
+  qCDebug(lcNetwork) << "setPaused():" << paused;
+  paused_ = paused;
+  if (!paused_ && (queuedCount_ > 0) && !getUrlTimer_->isActive())
+    getUrlTimer_->start(0);
+}
+
+/** @brief Queue host for dispatch if it has feeds and free connections
+ *----------------------------------------------------------------------------*/
+void RequestFeed::makeHostReady(const QString &host)
+{
+  HostState &state = hosts_[host];
+  int budget = state.throttled ? 1 : HOST_MAX_REQUESTS;
+  if (state.ready || state.feedsQueue.isEmpty() || (state.activeCount >= budget))
+    return;
+
+  state.ready = true;
+  if (state.nextRequestTime > clock_.elapsed())
+    delayedHosts_.insert(state.nextRequestTime, host);
+  else
+    readyHosts_.enqueue(host);
 }
 
-/** @brief Process request queue on timer timeouts
+/** @brief Return connection of finished feed to budget of its host
+ *----------------------------------------------------------------------------*/
+void RequestFeed::releaseHost(const QString &feedUrl)
+{
+  QString host = QUrl(feedUrl).host();
+  HostState &state = hosts_[host];
+  if (state.activeCount > 0)
+    state.activeCount--;
+  if (activeCount_ > 0)
+    activeCount_--;
+
+  makeHostReady(host);
+  // Host can be delayed by politeness or Retry-After, getQueuedUrl()
+  // arms the timer for the nearest delayed host
+  if (!readyHosts_.isEmpty() || !delayedHosts_.isEmpty())
+    getUrlTimer_->start(0);
+}
+
+/** @brief Dispatch queued feeds, one per ready host in round-robin order
+ *
+ * Hosts waiting for a free connection or politeness delay are not in
+ * readyHosts_, so feeds of other hosts never wait behind them
  *----------------------------------------------------------------------------*/
 void RequestFeed::getQueuedUrl()
 {
-  if ((currentFeeds_.count() >= numberRequests_) ||
-      (currentFeeds_.count() >= REPLY_MAX_COUNT)) {
-    getUrlTimer_->start();
+  if (paused_)
     return;
-  }
 
-  if (!feedsQueue_.isEmpty()) {
-    getUrlTimer_->start();
-    QString feedUrl = feedsQueue_.head();
+  qint64 now = clock_.elapsed();
+  while (!delayedHosts_.isEmpty() && (delayedHosts_.begin().key() <= now)) {
+    QMultiMap<qint64, QString>::iterator it = delayedHosts_.begin();
+    readyHosts_.enqueue(it.value());
+    delayedHosts_.erase(it);
+  }
 
-    if (hostList_.contains(QUrl(feedUrl).host())) {
-      foreach (QString url, currentFeeds_) {
-        if (QUrl(url).host() == QUrl(feedUrl).host()) {
-          return;
-        }
-      }
+  while (!readyHosts_.isEmpty() && (activeCount_ < numberRequests_)) {
+    QString host = readyHosts_.dequeue();
+    HostState &state = hosts_[host];
+    state.ready = false;
+
+    // Budget could shrink after host was queued, it will be queued again on release
+    int budget = state.throttled ? 1 : HOST_MAX_REQUESTS;
+    if (state.feedsQueue.isEmpty() || (state.activeCount >= budget))
+      continue;
+    // Server asked to slow down after host was queued
+    if (state.nextRequestTime > now) {
+      state.ready = true;
+      delayedHosts_.insert(state.nextRequestTime, host);
+      continue;
     }
-    int feedId = idsQueue_.dequeue();
-    feedUrl = feedsQueue_.dequeue();
 
-    emit setStatusFeed(feedId, "1 Update");
-
-    QUrl getUrl = QUrl::fromEncoded(feedUrl.toUtf8());
-    QString userInfo = userInfo_.dequeue();
-    if (!userInfo.isEmpty()) {
-      getUrl.setUserInfo(userInfo);
+    QueuedFeed feed = state.feedsQueue.dequeue();
+    queuedCount_--;
+    state.activeCount++;
+    activeCount_++;
+    if (state.throttled)
+      state.nextRequestTime = now + HOST_THROTTLED_DELAY;
+    makeHostReady(host);
+
+    emit setStatusFeed(feed.id, "1 Update");
+
+    QUrl getUrl = QUrl::fromEncoded(feed.url.toUtf8());
+    if (!standInUrl_.isEmpty())
+      getUrl = QUrl(QString("%1/feed/%2").arg(standInUrl_).arg(feed.id));
+    if (!feed.userInfo.isEmpty()) {
+      getUrl.setUserInfo(feed.userInfo);
 //      getUrl.addQueryItem("auth", getUrl.scheme());
     }
 
-    qDebug() << "getQueuedUrl() >>" << feedUrl << "countQueue=" << feedsQueue_.count();
-    QDateTime currentDate = dateQueue_.dequeue();
-    if (currentDate.isValid())
-      emit signalHead(getUrl, feedId, feedUrl, currentDate);
-    else
-      emit signalGet(getUrl, feedId, feedUrl, currentDate);
+    qCDebug(lcNetwork) << "getQueuedUrl() >>" << feed.url << "countQueue=" << queuedCount_;
+    emit signalGet(getUrl, feed.id, feed.url, feed.etag, feed.lastModified);
   }
+
+  if (!delayedHosts_.isEmpty())
+    getUrlTimer_->start(qMax(0, int(delayedHosts_.begin().key() - now)));
 }
 
-/** @brief Prepare and send network request to get head
+/** @brief Prepare and send conditional network request to get all data
+ *
+ * Validators of the previous reply are sent as If-None-Match and
+ * If-Modified-Since, so unchanged feeds are answered with 304 Not Modified
  *----------------------------------------------------------------------------*/
-void RequestFeed::slotHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                            const QDateTime &date, const int &count)
+void RequestFeed::slotGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
+                          const QString &etag, const QString &lastModified,
+                          const int &count)
 {
-  if (count)
-    Common::sleep(30);
-
-  qDebug() << objectName() << "::head:" << getUrl.toEncoded() << "feed:" << feedUrl << "countRepeats:" << count;
+  qCDebug(lcNetwork) << objectName() << "::get:" << getUrl.toEncoded() << "feed:" << feedUrl << "countRepeats:" <<count;
   QNetworkRequest request(getUrl);
+  request.setRawHeader("Accept", "application/atom+xml,application/rss+xml;q=0.9,application/xml;q=0.8,text/xml;q=0.7,*/*;q=0.6");
   request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
+  request.setRawHeader("Accept-Encoding", ContentDecoder::acceptEncoding());
+  if (!etag.isEmpty())
+    request.setRawHeader("If-None-Match", etag.toLatin1());
+  if (!lastModified.isEmpty())
+    request.setRawHeader("If-Modified-Since", lastModified.toLatin1());
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       QNetworkRequest::AlwaysNetwork);
 
-  currentUrls_.append(getUrl);
-  currentIds_.append(id);
-  currentFeeds_.append(feedUrl);
-  currentDates_.append(date);
-  currentCount_.append(count);
-  currentHead_.append(true);
-  currentTime_.append(timeoutRequest_);
-
-  QNetworkReply *reply = networkManager_->head(request);
+  QNetworkReply *reply = networkManager_->get(request);
   reply->setProperty("feedReply", QVariant(true));
-  requestUrl_.append(reply->url());
-  networkReply_.append(reply);
+  connect(reply, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+
+  RequestState state;
+  state.feedId = id;
+  state.feedUrl = feedUrl;
+  state.etag = etag;
+  state.lastModified = lastModified;
+  state.count = count;
+  state.decoder = NULL;
+  state.traceStart = Tracer::isEnabled() ? Tracer::timestamp() : -1;
+  requests_.insert(reply, state);
+  timeoutQueue_->add(reply, timeoutRequest_ * 1000);
 }
 
-/** @brief Prepare and send network request to get all data
+/** @brief Get decoder of reply body, create it on first chunk
  *----------------------------------------------------------------------------*/
-void RequestFeed::slotGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                           const QDateTime &date, const int &count)
+ContentDecoder *RequestFeed::contentDecoder(RequestState &state, QNetworkReply *reply)
 {
-  if (count)
-    Common::sleep(30);
+  if (!state.decoder)
+    state.decoder = new ContentDecoder(reply->rawHeader("Content-Encoding"));
+  return state.decoder;
+}
 
-  qDebug() << objectName() << "::get:" << getUrl.toEncoded() << "feed:" << feedUrl << "countRepeats:" <<count;
-  QNetworkRequest request(getUrl);
-  request.setRawHeader("Accept", "application/atom+xml,application/rss+xml;q=0.9,application/xml;q=0.8,text/xml;q=0.7,*/*;q=0.6");
-  request.setRawHeader("User-Agent", globals.userAgent().toUtf8());
+/** @brief Decode reply body as it arrives
+ *----------------------------------------------------------------------------*/
+void RequestFeed::slotReadyRead()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+  QHash<QNetworkReply*, RequestState>::iterator it = requests_.find(reply);
+  if (it == requests_.end())
+    return;
 
-  currentUrls_.append(getUrl);
-  currentIds_.append(id);
-  currentFeeds_.append(feedUrl);
-  currentDates_.append(date);
-  currentCount_.append(count);
-  currentHead_.append(false);
-  currentTime_.append(timeoutRequest_);
+  contentDecoder(it.value(), reply)->write(reply->readAll());
+}
 
-  QNetworkReply *reply = networkManager_->get(request);
-  reply->setProperty("feedReply", QVariant(true));
-  requestUrl_.append(reply->url());
-  networkReply_.append(reply);
+/** @brief Repeat request after delay without blocking event loop
+ *----------------------------------------------------------------------------*/
+void RequestFeed::scheduleRetry(const QUrl &url, const RequestState &state,
+                                int count, int delay)
+{
+  RetryRequest retry;
+  retry.url = url;
+  retry.feedId = state.feedId;
+  retry.feedUrl = state.feedUrl;
+  retry.etag = state.etag;
+  retry.lastModified = state.lastModified;
+  retry.count = count;
+
+  qint64 retryTime = clock_.elapsed() + delay;
+  retries_.insert(retryTime, retry);
+  if (retries_.begin().key() == retryTime)
+    retryTimer_->start(delay);
+
+  qCDebug(lcNetwork) << objectName() << "  repeat in" << delay << "ms:" << url.toString();
+}
+
+/** @brief Send repeats which delay is over
+ *----------------------------------------------------------------------------*/
+void RequestFeed::slotRetry()
+{
+  qint64 now = clock_.elapsed();
+  while (!retries_.isEmpty() && (retries_.begin().key() <= now)) {
+    RetryRequest retry = retries_.take(retries_.begin().key());
+    emit signalGet(retry.url, retry.feedId, retry.feedUrl, retry.etag,
+                   retry.lastModified, retry.count);
+  }
+
+  if (!retries_.isEmpty())
+    retryTimer_->start(int(qMax(qint64(0), retries_.begin().key() - now)));
 }
 
 /** @brief Process network reply
@@ -203,173 +341,167 @@ void RequestFeed::finished(QNetworkReply *reply)
 {
   QUrl replyUrl = reply->url();
 
-  qDebug() << "reply.finished():" << replyUrl.toString();
-  qDebug() << reply->header(QNetworkRequest::ContentTypeHeader);
-  qDebug() << reply->header(QNetworkRequest::ContentLengthHeader);
-  qDebug() << reply->header(QNetworkRequest::LocationHeader);
-  qDebug() << reply->header(QNetworkRequest::LastModifiedHeader);
-  qDebug() << reply->header(QNetworkRequest::CookieHeader);
-  qDebug() << reply->header(QNetworkRequest::SetCookieHeader);
-
-  int currentReplyIndex = currentUrls_.indexOf(replyUrl);
-
-  if (currentReplyIndex >= 0) {
-    currentTime_.removeAt(currentReplyIndex);
-    currentUrls_.removeAt(currentReplyIndex);
-    int feedId    = currentIds_.takeAt(currentReplyIndex);
-    QString feedUrl    = currentFeeds_.takeAt(currentReplyIndex);
-    QDateTime feedDate = currentDates_.takeAt(currentReplyIndex);
-    int count = currentCount_.takeAt(currentReplyIndex) + 1;
-    bool headOk = currentHead_.takeAt(currentReplyIndex);
+  qCDebug(lcNetwork) << "reply.finished():" << replyUrl.toString();
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::ContentTypeHeader);
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::ContentLengthHeader);
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::LocationHeader);
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::LastModifiedHeader);
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::CookieHeader);
+  qCDebug(lcNetwork) << reply->header(QNetworkRequest::SetCookieHeader);
+
+  if (requests_.contains(reply)) {
+    RequestState state = requests_.take(reply);
+    timeoutQueue_->remove(reply);
+    Tracer::addAsyncSpan("fetch", state.traceStart, state.feedId,
+                         reinterpret_cast<quintptr>(reply));
+    int feedId = state.feedId;
+    QString feedUrl = state.feedUrl;
+    QString etag = state.etag;
+    QString lastModified = state.lastModified;
+    int count = state.count + 1;
+    bool repeat = false;
+
+    ContentDecoder *decoder = contentDecoder(state, reply);
+    decoder->write(reply->readAll());
+
+    if (decoder->bytesReceived()) {
+      qCDebug(lcNetwork) << objectName() << "  received:" << decoder->bytesReceived()
+               << "decoded:" << decoder->bytesDecoded();
+      emit signalBytesReceived(feedId, decoder->bytesReceived(),
+                               decoder->bytesDecoded());
+    }
 
     if (reply->error() != QNetworkReply::NoError) {
-      qDebug() << "  error retrieving RSS feed:" << reply->error() << reply->errorString();
-      if (!headOk) {
-        if (reply->error() == QNetworkReply::AuthenticationRequiredError)
-          emit getUrlDone(-2, feedId, feedUrl, tr("Server requires authentication!"));
-        else if (reply->error() == QNetworkReply::ContentNotFoundError)
-          emit getUrlDone(-5, feedId, feedUrl, tr("Server replied: Not Found!"));
-        else {
-          if (reply->errorString().contains("Service Temporarily Unavailable")) {
-            if (!hostList_.contains(QUrl(feedUrl).host())) {
-              hostList_.append(QUrl(feedUrl).host());
-              count--;
-            }
+      qCDebug(lcNetwork) << "  error retrieving RSS feed:" << reply->error() << reply->errorString();
+      if (reply->error() == QNetworkReply::AuthenticationRequiredError)
+        emit getUrlDone(-2, feedId, feedUrl, tr("Server requires authentication!"));
+      else if (reply->error() == QNetworkReply::ContentNotFoundError)
+        emit getUrlDone(-5, feedId, feedUrl, tr("Server replied: Not Found!"));
+      else {
+        int retryAfter = RetryPolicy::retryAfterDelay(reply);
+        if ((retryAfter >= 0) ||
+            reply->errorString().contains("Service Temporarily Unavailable")) {
+          HostState &hostState = hosts_[QUrl(feedUrl).host()];
+          if (!hostState.throttled) {
+            hostState.throttled = true;
+            count--;
           }
+          // Other feeds of this host wait too
+          hostState.nextRequestTime = qMax(hostState.nextRequestTime,
+                                           clock_.elapsed() + qMax(0, retryAfter));
+        }
 
-          if (count < numberRepeats_) {
-            emit signalGet(replyUrl, feedId, feedUrl, feedDate, count);
-          } else {
-            emit getUrlDone(-1, feedId, feedUrl, QString("%1 (%2)").arg(reply->errorString()).arg(reply->error()));
-          }
+        if ((count < numberRepeats_) && (retryAfter <= RetryPolicy::maxDelay)) {
+          repeat = true;
+          scheduleRetry(replyUrl, state, count,
+                        qMax(retryAfter, RetryPolicy::backoffDelay(qMax(count, 1))));
+        } else {
+          emit getUrlDone(-1, feedId, feedUrl, QString("%1 (%2)").arg(reply->errorString()).arg(reply->error()));
         }
-      } else {
-        emit signalGet(replyUrl, feedId, feedUrl, feedDate);
       }
     } else {
       QUrl redirectionTarget = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
       if (redirectionTarget.isValid()) {
         if (count < (numberRepeats_ + 3)) {
-          if (headOk && (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 302)) {
-            emit signalGet(replyUrl, feedId, feedUrl, feedDate);
-          } else {
-            QString host(QUrl::fromEncoded(feedUrl.toUtf8()).host());
-            if (redirectionTarget.host().isEmpty()) {
-              if (redirectionTarget.path() == ".") {
-                if (redirectionTarget.hasQuery()) {
+          QString host(QUrl::fromEncoded(feedUrl.toUtf8()).host());
+          if (redirectionTarget.host().isEmpty()) {
+            if (redirectionTarget.path() == ".") {
+              if (redirectionTarget.hasQuery()) {
 #if QT_VERSION >= 0x050000
-                  QString query = redirectionTarget.query();
-                  redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
-                  redirectionTarget.setQuery(query);
+                QString query = redirectionTarget.query();
+                redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
+                redirectionTarget.setQuery(query);
 #else
-                  QByteArray query = redirectionTarget.encodedQuery();
-                  redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
-                  redirectionTarget.setEncodedQuery(query);
+                QByteArray query = redirectionTarget.encodedQuery();
+                redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + replyUrl.path());
+                redirectionTarget.setEncodedQuery(query);
 #endif
-                }
-              } else {
-                redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + redirectionTarget.toString());
               }
-            }
-            if (redirectionTarget.scheme().isEmpty())
-              redirectionTarget.setScheme(QUrl(feedUrl).scheme());
-            if (reply->operation() == QNetworkAccessManager::HeadOperation) {
-              qDebug() << objectName() << "  head redirect..." << redirectionTarget.toString();
-              emit signalHead(redirectionTarget, feedId, feedUrl, feedDate, count);
-            }
-            else {
-              qDebug() << objectName() << "  get redirect..." << redirectionTarget.toString();
-              emit signalGet(redirectionTarget, feedId, feedUrl, feedDate, count);
+            } else {
+              redirectionTarget.setUrl(replyUrl.scheme() + "://" + host + redirectionTarget.toString());
             }
           }
+          if (redirectionTarget.scheme().isEmpty())
+            redirectionTarget.setScheme(QUrl(feedUrl).scheme());
+          qCDebug(lcNetwork) << objectName() << "  get redirect..." << redirectionTarget.toString();
+          repeat = true;
+          emit signalGet(redirectionTarget, feedId, feedUrl, etag, lastModified, count);
         } else {
           emit getUrlDone(-4, feedId, feedUrl, tr("Redirect error!"));
         }
+      } else if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        // Feed not modified since previous request, nothing to parse
+        qCDebug(lcNetwork) << objectName() << "  not modified:" << feedUrl;
+        emit getUrlDone(queuedCount_, feedId, feedUrl);
+      } else if (decoder->hasError()) {
+        emit getUrlDone(-1, feedId, feedUrl, tr("Error decoding compressed data!"));
       } else {
         QDateTime replyDate = reply->header(QNetworkRequest::LastModifiedHeader).toDateTime();
         QDateTime replyLocalDate = QDateTime(replyDate.date(), replyDate.time());
-
-        qDebug() << feedDate << replyDate << replyLocalDate;
-        qDebug() << feedDate.toMSecsSinceEpoch() << replyDate.toMSecsSinceEpoch() << replyLocalDate.toMSecsSinceEpoch();
-        if ((reply->operation() == QNetworkAccessManager::HeadOperation) &&
-            ((!feedDate.isValid()) || (!replyLocalDate.isValid()) ||
-             (feedDate != replyLocalDate) || !replyDate.toMSecsSinceEpoch())) {
-          emit signalGet(replyUrl, feedId, feedUrl, feedDate);
+        QString replyEtag = QString::fromLatin1(reply->rawHeader("ETag"));
+        QString replyLastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+
+        QString codecName;
+        QzRegExp rx("charset=([^\t]+)$", Qt::CaseInsensitive);
+        int pos = rx.indexIn(reply->header(QNetworkRequest::ContentTypeHeader).toString());
+        if (pos > -1) {
+          codecName = rx.cap(1);
         }
-        else {
-          QString codecName;
-          QzRegExp rx("charset=([^\t]+)$", Qt::CaseInsensitive);
-          int pos = rx.indexIn(reply->header(QNetworkRequest::ContentTypeHeader).toString());
-          if (pos > -1) {
-            codecName = rx.cap(1);
-          }
 
-          QByteArray data = reply->readAll();
-          data = data.trimmed();
+        QByteArray data = decoder->data();
+        data = data.trimmed();
 
-          rx.setPattern("&(?!([a-z0-9#]+;))");
-          pos = 0;
-          while ((pos = rx.indexIn(QString::fromLatin1(data), pos)) != -1) {
-            data.replace(pos, 1, "&amp;");
-            pos += 1;
-          }
+        rx.setPattern("&(?!([a-z0-9#]+;))");
+        pos = 0;
+        while ((pos = rx.indexIn(QString::fromLatin1(data), pos)) != -1) {
+          data.replace(pos, 1, "&amp;");
+          pos += 1;
+        }
 
-          data.replace("<br>", "<br/>");
+        data.replace("<br>", "<br/>");
 
-          if (data.indexOf("</rss>") > 0)
-            data.resize(data.indexOf("</rss>") + 6);
-          if (data.indexOf("</feed>") > 0)
-            data.resize(data.indexOf("</feed>") + 7);
-          if (data.indexOf("</rdf:RDF>") > 0)
-            data.resize(data.indexOf("</rdf:RDF>") + 10);
+        if (data.indexOf("</rss>") > 0)
+          data.resize(data.indexOf("</rss>") + 6);
+        if (data.indexOf("</feed>") > 0)
+          data.resize(data.indexOf("</feed>") + 7);
+        if (data.indexOf("</rdf:RDF>") > 0)
+          data.resize(data.indexOf("</rdf:RDF>") + 10);
 
-          emit getUrlDone(feedsQueue_.count(), feedId, feedUrl, "", data, replyLocalDate, codecName);
-        }
+        emit getUrlDone(queuedCount_, feedId, feedUrl, "", data, replyLocalDate, codecName,
+                        replyEtag, replyLastModified);
       }
     }
+
+    delete decoder;
+    if (!repeat)
+      releaseHost(feedUrl);
   } else {
     qCritical() << "Request Url error: " << replyUrl.toString() << reply->errorString();
   }
 
-  int replyIndex = requestUrl_.indexOf(replyUrl);
-  if (replyIndex >= 0) {
-    requestUrl_.removeAt(replyIndex);
-    networkReply_.removeAt(replyIndex);
-  }
-
   reply->abort();
   reply->deleteLater();
 }
 
-/** @brief Timeout to delete network requests which has no answer
+/** @brief Delete network request which has no answer in time
  *----------------------------------------------------------------------------*/
-void RequestFeed::slotRequestTimeout()
+void RequestFeed::slotRequestTimeout(QNetworkReply *reply)
 {
-  for (int i = currentTime_.count() - 1; i >= 0; i--) {
-    int time = currentTime_.at(i) - 1;
-    if (time <= 0) {
-      QUrl url = currentUrls_.takeAt(i);
-      int feedId    = currentIds_.takeAt(i);
-      QString feedUrl = currentFeeds_.takeAt(i);
-      QDateTime feedDate = currentDates_.takeAt(i);
-      int count = currentCount_.takeAt(i) + 1;
-      currentTime_.removeAt(i);
-      currentHead_.removeAt(i);
-
-      int replyIndex = requestUrl_.indexOf(url);
-      if (replyIndex >= 0) {
-        QUrl replyUrl = requestUrl_.takeAt(replyIndex);
-        QNetworkReply *reply = networkReply_.takeAt(replyIndex);
-        reply->deleteLater();
-
-        if (count < numberRepeats_) {
-          emit signalGet(replyUrl, feedId, feedUrl, feedDate, count);
-        } else {
-          emit getUrlDone(-3, feedId, feedUrl, tr("Request timeout!"));
-        }
-      }
-    } else {
-      currentTime_.replace(i, time);
-    }
+  if (!requests_.contains(reply))
+    return;
+
+  RequestState state = requests_.take(reply);
+  Tracer::addAsyncSpan("fetch", state.traceStart, state.feedId,
+                       reinterpret_cast<quintptr>(reply));
+  int count = state.count + 1;
+  QUrl replyUrl = reply->url();
+  delete state.decoder;
+  reply->deleteLater();
+
+  if (count < numberRepeats_) {
+    scheduleRetry(replyUrl, state, count, RetryPolicy::backoffDelay(count));
+  } else {
+    emit getUrlDone(-3, state.feedId, state.feedUrl, tr("Request timeout!"));
+    releaseHost(state.feedUrl);
   }
 }
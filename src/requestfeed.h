@@ -19,6 +19,8 @@
 #define REQUESTFEED_H
 
 #include <QDateTime>
+#include <QHash>
+#include <QMap>
 #include <QObject>
 #include <QQueue>
 #include <QNetworkReply>
@@ -26,6 +28,9 @@
 #include <QElapsedTimer>
 
 #include "networkmanager.h"
+#include "timeoutqueue.h"
+
+class ContentDecoder;
 
 class RequestFeed : public QObject
 {
@@ -38,52 +43,103 @@ public:
   void disconnectObjects();
 
 public slots:
-  void requestUrl(int id, QString urlString, QDateTime date, QString userInfo = "");
+  void requestUrl(int id, QString urlString, QString etag,
+                  QString lastModified, QString userInfo = "");
   void stopRequest();
-  void slotHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                const QDateTime &date, const int &count);
+  void setStandInUrl(const QString &url);
+  void setPaused(bool paused);
   void slotGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
-               const QDateTime &date, const int &count);
+               const QString &etag, const QString &lastModified,
+               const int &count);
 
 signals:
   void getUrlDone(int result, int feedId, QString feedUrl = "",
                   QString error = "", QByteArray data = NULL,
-                  QDateTime dtReply = QDateTime(), QString codecName = "");
-  void signalHead(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                  const QDateTime &date, const int &count = 0);
+                  QDateTime dtReply = QDateTime(), QString codecName = "",
+                  QString etag = "", QString lastModified = "");
   void signalGet(const QUrl &getUrl, const int &id, const QString &feedUrl,
-                 const QDateTime &date, const int &count = 0);
+                 const QString &etag, const QString &lastModified,
+                 const int &count = 0);
   void setStatusFeed(int feedId, QString status);
+  void signalBytesReceived(int feedId, qint64 bytesReceived, qint64 bytesDecoded);
 
 private slots:
   void getQueuedUrl();
   void finished(QNetworkReply *reply);
-  void slotRequestTimeout();
+  void slotRequestTimeout(QNetworkReply *reply);
+  void slotReadyRead();
+  void slotRetry();
 
 private:
+  struct QueuedFeed
+  {
+    int id;
+    QString url;
+    QString etag;
+    QString lastModified;
+    QString userInfo;
+  };
+
+  /** Requests waiting for one host and its connection budget */
+  struct HostState
+  {
+    HostState() : activeCount(0), throttled(false), ready(false), nextRequestTime(0) {}
+    QQueue<QueuedFeed> feedsQueue;
+    int activeCount;
+    bool throttled;
+    bool ready;             // host is in readyHosts_ or delayedHosts_
+    qint64 nextRequestTime; // politeness delay, clock_ time in ms
+  };
+
+  /** State of request in flight, keyed by its network reply */
+  struct RequestState
+  {
+    int feedId;
+    QString feedUrl;
+    QString etag;
+    QString lastModified;
+    int count;
+    ContentDecoder *decoder;
+    qint64 traceStart;
+  };
+
+  /** Repeat of request waiting for its backoff delay */
+  struct RetryRequest
+  {
+    QUrl url;
+    int feedId;
+    QString feedUrl;
+    QString etag;
+    QString lastModified;
+    int count;
+  };
+
+  ContentDecoder *contentDecoder(RequestState &state, QNetworkReply *reply);
+  void scheduleRetry(const QUrl &url, const RequestState &state, int count, int delay);
+  void makeHostReady(const QString &host);
+  void releaseHost(const QString &feedUrl);
+
   NetworkManager *networkManager_;
 
   int timeoutRequest_;
   int numberRequests_;
   int numberRepeats_;
-  QTimer *timeout_;
+  TimeoutQueue *timeoutQueue_;
   QTimer *getUrlTimer_;
+  QTimer *retryTimer_;
+
+  QHash<QString, HostState> hosts_;
+  QQueue<QString> readyHosts_;
+  QMultiMap<qint64, QString> delayedHosts_;
+  QElapsedTimer clock_;
+  int queuedCount_;
+  int activeCount_;
+  bool paused_;  // parse queue is full, no new requests
+
+  QString standInUrl_;  // requests are sent to local stand-in server
 
-  QQueue<int> idsQueue_;
-  QQueue<QString> feedsQueue_;
-  QQueue<QDateTime> dateQueue_;
-  QQueue<QString> userInfo_;
-
-  QList<QUrl> currentUrls_;
-  QList<int> currentIds_;
-  QList<QString> currentFeeds_;
-  QList<QDateTime> currentDates_;
-  QList<int> currentCount_;
-  QList<bool> currentHead_;
-  QList<int> currentTime_;
-  QList<QUrl> requestUrl_;
-  QList<QNetworkReply*> networkReply_;
-  QList<QString> hostList_;
+  QHash<QNetworkReply*, RequestState> requests_;
+  QMultiMap<qint64, RetryRequest> retries_;
 
 };
 
@@ -0,0 +1,259 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "updatebenchmark.h"
+
+#include "mainapplication.h"
+#include "database.h"
+#include "feedcorpus.h"
+#include "parseobject.h"
+#include "requestfeed.h"
+#include "settings.h"
+#include "sqlitedriver.h"
+#include "standinserver.h"
+
+#include <QDebug>
+#include <QDir>
+
+#define STALL_INTERVAL 10
+#define BENCHMARK_CONNECTION "benchmarkConnection"
+
+BenchmarkUpdater::BenchmarkUpdater(const QString &standInUrl, QObject *parent)
+  : QObject(parent)
+  , standInUrl_(standInUrl)
+  , requestFeed_(NULL)
+  , parseObject_(NULL)
+  , feedsCount_(0)
+  , pendingCount_(0)
+{
+  setObjectName("benchmarkUpdater_");
+}
+
+/** @brief Copy database and request all feeds from stand-in server
+ *---------------------------------------------------------------------------*/
+void BenchmarkUpdater::run()
+{
+  scratchFileName_ = QDir(FeedCorpus::corpusDir()).absoluteFilePath("benchmark.db");
+  QFile::remove(scratchFileName_);
+  if (!QFile::copy(mainApp->dbFileName(), scratchFileName_)) {
+    qWarning() << "Update benchmark: can't create scratch database" << scratchFileName_;
+    emit finished(0);
+    return;
+  }
+
+  QSqlDatabase db = QSqlDatabase::addDatabase(new SQLiteDriver(), BENCHMARK_CONNECTION);
+  db.setDatabaseName(scratchFileName_);
+  db.open();
+  Database::setPragma(db);
+
+  Settings settings;
+  int timeoutRequest = settings.value("Settings/timeoutRequest", 15).toInt();
+  int numberRequests = settings.value("Settings/numberRequest", 10).toInt();
+  int numberRepeats = settings.value("Settings/numberRepeats", 2).toInt();
+  int parseThreads = settings.value("Settings/parseThreads",
+                                    qBound(1, QThread::idealThreadCount() - 1, 4)).toInt();
+
+  requestFeed_ = new RequestFeed(timeoutRequest, numberRequests, numberRepeats, this);
+  requestFeed_->setStandInUrl(standInUrl_);
+  parseObject_ = new ParseObject(this, db);
+  for (int i = 0; i < qMax(1, parseThreads); ++i) {
+    QThread *parseThread = new QThread();
+    parseThread->setObjectName(QString("benchmarkParseThread_%1").arg(i));
+    ParseWorker *parseWorker = new ParseWorker();
+    parseWorker->moveToThread(parseThread);
+    parseThreads_.append(parseThread);
+    parseWorkers_.append(parseWorker);
+    parseThread->start(QThread::LowPriority);
+  }
+  parseObject_->setWorkers(parseWorkers_);
+
+  connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString)),
+          this, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)));
+  connect(parseObject_, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
+          this, SLOT(finishUpdate(int,bool,int,QString)));
+  connect(parseObject_, SIGNAL(signalQueueFull(bool)),
+          requestFeed_, SLOT(setPaused(bool)));
+
+  QSqlQuery q(db);
+  q.exec("SELECT id, xmlUrl, etag, lastModified FROM feeds "
+         "WHERE xmlUrl!='' AND disableUpdate=0");
+  while (q.next()) {
+    requestFeed_->requestUrl(q.value(0).toInt(), q.value(1).toString(),
+                             q.value(2).toString(), q.value(3).toString());
+    feedsCount_++;
+    pendingCount_++;
+  }
+  q.finish();
+
+  if (!pendingCount_)
+    QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+}
+
+void BenchmarkUpdater::getUrlDone(int result, int feedId, QString feedUrl, QString error,
+                                  QByteArray data, QDateTime dtReply, QString codecName)
+{
+  Q_UNUSED(result)
+  Q_UNUSED(feedUrl)
+  Q_UNUSED(error)
+
+  if (data.isEmpty())
+    feedDone();
+  else
+    parseObject_->parseXml(data, feedId, dtReply, codecName);
+}
+
+void BenchmarkUpdater::finishUpdate(int feedId, bool changed, int newCount, QString status)
+{
+  Q_UNUSED(feedId)
+  Q_UNUSED(changed)
+  Q_UNUSED(newCount)
+  Q_UNUSED(status)
+
+  feedDone();
+}
+
+void BenchmarkUpdater::feedDone()
+{
+  // Objects of pipeline are deleted outside of their signals
+  if (--pendingCount_ <= 0)
+    QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+}
+
+/** @brief Delete pipeline and scratch database
+ *---------------------------------------------------------------------------*/
+void BenchmarkUpdater::finish()
+{
+  foreach (ParseWorker *parseWorker, parseWorkers_)
+    parseWorker->closeQueue();
+  delete requestFeed_;
+  requestFeed_ = NULL;
+  delete parseObject_;
+  parseObject_ = NULL;
+  foreach (QThread *parseThread, parseThreads_) {
+    parseThread->exit();
+    parseThread->wait();
+    delete parseThread;
+  }
+  qDeleteAll(parseWorkers_);
+  parseThreads_.clear();
+  parseWorkers_.clear();
+
+  QSqlDatabase::database(BENCHMARK_CONNECTION, false).close();
+  QSqlDatabase::removeDatabase(BENCHMARK_CONNECTION);
+  QFile::remove(scratchFileName_);
+
+  emit finished(feedsCount_);
+}
+
+//------------------------------------------------------------------------------
+UpdateBenchmark::UpdateBenchmark(QObject *parent)
+  : QObject(parent)
+  , server_(NULL)
+  , updater_(NULL)
+  , lastTick_(0)
+  , stallTime_(0)
+  , maxStall_(0)
+{
+  setObjectName("updateBenchmark_");
+
+  serverThread_ = new QThread();
+  serverThread_->setObjectName("standInServerThread_");
+  updateThread_ = new QThread();
+  updateThread_->setObjectName("benchmarkUpdateThread_");
+
+  stallTimer_ = new QTimer(this);
+  stallTimer_->setInterval(STALL_INTERVAL);
+  connect(stallTimer_, SIGNAL(timeout()), this, SLOT(slotStallTimer()));
+}
+
+UpdateBenchmark::~UpdateBenchmark()
+{
+  stopThreads();
+  delete server_;
+  delete serverThread_;
+  delete updateThread_;
+}
+
+void UpdateBenchmark::start()
+{
+  server_ = new StandInServer();
+  server_->moveToThread(serverThread_);
+  serverThread_->start();
+
+  bool started = false;
+  QMetaObject::invokeMethod(server_, "start", Qt::BlockingQueuedConnection,
+                            Q_RETURN_ARG(bool, started));
+  if (!started) {
+    deleteLater();
+    return;
+  }
+
+  updater_ = new BenchmarkUpdater(server_->baseUrl());
+  updater_->moveToThread(updateThread_);
+  connect(updateThread_, SIGNAL(started()), updater_, SLOT(run()));
+  connect(updater_, SIGNAL(finished(int)), this, SLOT(slotFinished(int)));
+
+  qWarning() << "Update benchmark: start";
+  totalTime_.start();
+  stallTimer_->start();
+  updateThread_->start(QThread::LowPriority);
+}
+
+/** @brief Accumulate time event loop of UI thread was late for timer
+ *----------------------------------------------------------------------------*/
+void UpdateBenchmark::slotStallTimer()
+{
+  qint64 now = totalTime_.elapsed();
+  qint64 stall = now - lastTick_ - STALL_INTERVAL;
+  if (stall > 0) {
+    stallTime_ += stall;
+    maxStall_ = qMax(maxStall_, stall);
+  }
+  lastTick_ = now;
+}
+
+void UpdateBenchmark::slotFinished(int feedsCount)
+{
+  qint64 elapsed = totalTime_.elapsed();
+  stallTimer_->stop();
+  stopThreads();
+
+  double requestsPerSecond = server_->requestsCount() * 1000.0 / qMax(elapsed, qint64(1));
+  qWarning() << QString("Update benchmark: %1 feeds in %2 ms, %3 bytes, %4 requests (%5 req/s), "
+                        "UI stalled %6 ms (max %7 ms)").
+                arg(feedsCount).arg(elapsed).arg(server_->bytesSent()).
+                arg(server_->requestsCount()).arg(requestsPerSecond, 0, 'f', 1).
+                arg(stallTime_).arg(maxStall_);
+
+  deleteLater();
+}
+
+/** @brief Stop threads, then objects living in them can be deleted here
+ *----------------------------------------------------------------------------*/
+void UpdateBenchmark::stopThreads()
+{
+  updateThread_->exit();
+  updateThread_->wait();
+  delete updater_;
+  updater_ = NULL;
+
+  // Server is closed in own thread, its sockets belong to it
+  if (server_ && serverThread_->isRunning())
+    QMetaObject::invokeMethod(server_, "stop", Qt::BlockingQueuedConnection);
+  serverThread_->exit();
+  serverThread_->wait();
+}
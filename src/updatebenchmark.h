@@ -0,0 +1,103 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef UPDATEBENCHMARK_H
+#define UPDATEBENCHMARK_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+class ParseObject;
+class ParseWorker;
+class RequestFeed;
+class StandInServer;
+
+/** @brief Request and parse of all feeds into scratch database
+ *
+ * Runs in own thread with own request and parse objects against copy of
+ * database, so benchmark never changes feeds of user
+ *----------------------------------------------------------------------------*/
+class BenchmarkUpdater : public QObject
+{
+  Q_OBJECT
+public:
+  explicit BenchmarkUpdater(const QString &standInUrl, QObject *parent = 0);
+
+public slots:
+  void run();
+
+signals:
+  void finished(int feedsCount);
+
+private slots:
+  void getUrlDone(int result, int feedId, QString feedUrl, QString error,
+                  QByteArray data, QDateTime dtReply, QString codecName);
+  void finishUpdate(int feedId, bool changed, int newCount, QString status);
+  void finish();
+
+private:
+  void feedDone();
+
+  QString standInUrl_;
+  QString scratchFileName_;
+  RequestFeed *requestFeed_;
+  ParseObject *parseObject_;
+  QList<ParseWorker*> parseWorkers_;
+  QList<QThread*> parseThreads_;
+  int feedsCount_;
+  int pendingCount_;
+
+};
+
+/** @brief Full "update all" cycle against local stand-in server
+ *
+ * Stand-in server and update run in own threads, UI thread only measures
+ * time it was stalled as lateness of a short periodic timer. Reports total
+ * time, bytes, requests per second and stall time
+ *----------------------------------------------------------------------------*/
+class UpdateBenchmark : public QObject
+{
+  Q_OBJECT
+public:
+  explicit UpdateBenchmark(QObject *parent = 0);
+  ~UpdateBenchmark();
+
+  void start();
+
+private slots:
+  void slotFinished(int feedsCount);
+  void slotStallTimer();
+
+private:
+  void stopThreads();
+
+  QThread *serverThread_;
+  QThread *updateThread_;
+  StandInServer *server_;
+  BenchmarkUpdater *updater_;
+  QTimer *stallTimer_;
+  QElapsedTimer totalTime_;
+  qint64 lastTick_;
+  qint64 stallTime_;
+  qint64 maxStall_;
+
+};
+
+#endif // UPDATEBENCHMARK_H
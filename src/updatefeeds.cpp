@@ -19,7 +19,12 @@
 
 #include "mainapplication.h"
 #include "database.h"
+#include "common.h"
+#include "feedcorpus.h"
+#include "logging.h"
 #include "settings.h"
+#include "updatebenchmark.h"
+#include "xmldecoder.h"
 
 #include <QDebug>
 #include <qzregexp.h>
@@ -47,14 +52,29 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
   int timeoutRequest = settings.value("Settings/timeoutRequest", 15).toInt();
   int numberRequests = settings.value("Settings/numberRequest", 10).toInt();
   int numberRepeats = settings.value("Settings/numberRepeats", 2).toInt();
+  int parseThreads = settings.value("Settings/parseThreads",
+                                    qBound(1, QThread::idealThreadCount() - 1, 4)).toInt();
 
   requestFeed_ = new RequestFeed(timeoutRequest, numberRequests, numberRepeats);
 
   parseObject_ = new ParseObject();
 
+  qRegisterMetaType<ParseJob>("ParseJob");
+  for (int i = 0; i < qMax(1, parseThreads); ++i) {
+    QThread *parseThread = new QThread();
+    parseThread->setObjectName(QString("parseThread_%1").arg(i));
+    ParseWorker *parseWorker = new ParseWorker();
+    parseWorker->moveToThread(parseThread);
+    parseThreads_.append(parseThread);
+    parseWorkers_.append(parseWorker);
+  }
+  parseObject_->setWorkers(parseWorkers_);
+  connect(parseObject_, SIGNAL(signalQueueFull(bool)),
+          requestFeed_, SLOT(setPaused(bool)));
+
   if (addFeed_) {
-    connect(parent, SIGNAL(signalRequestUrl(int,QString,QDateTime,QString)),
-            requestFeed_, SLOT(requestUrl(int,QString,QDateTime,QString)));
+    connect(parent, SIGNAL(signalRequestUrl(int,QString,QString,QString,QString)),
+            requestFeed_, SLOT(requestUrl(int,QString,QString,QString,QString)));
     connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)),
             parent, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)));
 
@@ -69,23 +89,23 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
     updateObject_ = new UpdateObject();
     faviconObject_ = new FaviconObject();
 
-    connect(updateObject_, SIGNAL(signalRequestUrl(int,QString,QDateTime,QString)),
-            requestFeed_, SLOT(requestUrl(int,QString,QDateTime,QString)));
-    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)),
-            updateObject_, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString)));
+    connect(updateObject_, SIGNAL(signalRequestUrl(int,QString,QString,QString,QString)),
+            requestFeed_, SLOT(requestUrl(int,QString,QString,QString,QString)));
+    connect(requestFeed_, SIGNAL(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString)),
+            updateObject_, SLOT(getUrlDone(int,int,QString,QString,QByteArray,QDateTime,QString,QString,QString)));
     connect(requestFeed_, SIGNAL(setStatusFeed(int,QString)),
             parent, SLOT(setStatusFeed(int,QString)));
+    connect(requestFeed_, SIGNAL(signalBytesReceived(int,qint64,qint64)),
+            updateObject_, SLOT(slotBytesReceived(int,qint64,qint64)));
     connect(parent, SIGNAL(signalStopUpdate()),
             requestFeed_, SLOT(stopRequest()));
 
     connect(parent, SIGNAL(signalGetFeedTimer(int)),
             updateObject_, SLOT(slotGetFeedTimer(int)));
-    connect(parent, SIGNAL(signalGetAllFeedsTimer()),
-            updateObject_, SLOT(slotGetAllFeedsTimer()));
     connect(parent, SIGNAL(signalGetAllFeeds()),
             updateObject_, SLOT(slotGetAllFeeds()));
-    connect(parent, SIGNAL(signalGetFeed(int,QString,QDateTime,int)),
-            updateObject_, SLOT(slotGetFeed(int,QString,QDateTime,int)));
+    connect(parent, SIGNAL(signalGetFeed(int,QString,int)),
+            updateObject_, SLOT(slotGetFeed(int,QString,int)));
     connect(parent, SIGNAL(signalGetFeedsFolder(QString)),
             updateObject_, SLOT(slotGetFeedsFolder(QString)));
     connect(parent, SIGNAL(signalImportFeeds(QByteArray)),
@@ -100,14 +120,14 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
             parent, SLOT(feedsModelReload()),
             Qt::BlockingQueuedConnection);
 
-    connect(updateObject_, SIGNAL(xmlReadyParse(QByteArray,int,QDateTime,QString)),
-            parseObject_, SLOT(parseXml(QByteArray,int,QDateTime,QString)),
+    connect(updateObject_, SIGNAL(xmlReadyParse(QByteArray,int,QDateTime,QString,QString,QString,QString)),
+            parseObject_, SLOT(parseXml(QByteArray,int,QDateTime,QString,QString,QString,QString)),
             Qt::QueuedConnection);
     connect(parseObject_, SIGNAL(signalFinishUpdate(int,bool,int,QString)),
             updateObject_, SLOT(finishUpdate(int,bool,int,QString)),
             Qt::QueuedConnection);
-    connect(updateObject_, SIGNAL(feedUpdated(int,bool,int,bool)),
-            parent, SLOT(slotUpdateFeed(int,bool,int,bool)));
+    connect(updateObject_, SIGNAL(feedUpdated(int,bool,int,bool,qint64,int)),
+            parent, SLOT(slotUpdateFeed(int,bool,int,bool,qint64,int)));
     connect(updateObject_, SIGNAL(setStatusFeed(int,QString)),
             parent, SLOT(setStatusFeed(int,QString)));
 
@@ -185,6 +205,10 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
 
     connect(parent, SIGNAL(signalQuitApp()),
             updateObject_, SLOT(quitApp()));
+    qRegisterMetaType<UpdateSettings>("UpdateSettings");
+    connect(parent, SIGNAL(signalUpdateSettings(UpdateSettings)),
+            updateObject_, SLOT(setUpdateSettings(UpdateSettings)),
+            Qt::QueuedConnection);
     connect(this, SIGNAL(signalSaveMemoryDatabase()),
             updateObject_, SLOT(saveMemoryDatabase()));
 
@@ -201,12 +225,18 @@ UpdateFeeds::UpdateFeeds(QObject *parent, bool addFeed)
 
   getFeedThread_->start(QThread::LowPriority);
   updateFeedThread_->start(QThread::LowPriority);
+  foreach (QThread *parseThread, parseThreads_)
+    parseThread->start(QThread::LowPriority);
 }
 
 UpdateFeeds::~UpdateFeeds()
 {
   requestFeed_->deleteLater();
   parseObject_->deleteLater();
+  foreach (ParseWorker *parseWorker, parseWorkers_) {
+    parseWorker->closeQueue();
+    parseWorker->deleteLater();
+  }
 
   if (!addFeed_) {
     updateObject_->deleteLater();
@@ -224,6 +254,12 @@ UpdateFeeds::~UpdateFeeds()
   updateFeedThread_->exit();
   updateFeedThread_->wait();
   delete updateFeedThread_;
+
+  foreach (QThread *parseThread, parseThreads_) {
+    parseThread->exit();
+    parseThread->wait();
+    delete parseThread;
+  }
 }
 
 void UpdateFeeds::disconnectObjects()
@@ -255,6 +291,56 @@ void UpdateFeeds::startSaveTimer()
   saveMemoryDBTimer_->start(saveInterval*60*1000);
 }
 
+/** @brief Run task over recorded corpus in separate thread
+ * @details Task has slot run() and signal finished(), it is deleted
+ *   with thread when finished
+ *---------------------------------------------------------------------------*/
+void UpdateFeeds::startCorpusTask(QObject *task, const QString &threadName)
+{
+  QThread *taskThread = new QThread();
+  taskThread->setObjectName(threadName);
+  task->moveToThread(taskThread);
+
+  connect(taskThread, SIGNAL(started()), task, SLOT(run()));
+  connect(task, SIGNAL(finished()), taskThread, SLOT(quit()));
+  connect(task, SIGNAL(finished()), task, SLOT(deleteLater()));
+  connect(taskThread, SIGNAL(finished()), taskThread, SLOT(deleteLater()));
+
+  taskThread->start(QThread::LowPriority);
+}
+
+/** @brief Start replay of recorded feed data in separate thread
+ *---------------------------------------------------------------------------*/
+void UpdateFeeds::startCorpusReplay()
+{
+  startCorpusTask(new CorpusReplay(), "replayThread_");
+}
+
+/** @brief Time date parsing on dates of recorded feed data
+ *---------------------------------------------------------------------------*/
+void UpdateFeeds::startDateBenchmark()
+{
+  startCorpusTask(new DateBenchmark(), "dateBenchmarkThread_");
+}
+
+/** @brief Time charset decoding of recorded feed data
+ *---------------------------------------------------------------------------*/
+void UpdateFeeds::startDecoderBenchmark()
+{
+  startCorpusTask(new DecoderBenchmark(), "decoderBenchmarkThread_");
+}
+
+/** @brief Run update of all feeds against local stand-in server
+ * @details Update is written into scratch copy of database
+ *---------------------------------------------------------------------------*/
+void UpdateFeeds::startUpdateBenchmark()
+{
+  if (addFeed_) return;
+
+  UpdateBenchmark *updateBenchmark = new UpdateBenchmark(this);
+  updateBenchmark->start();
+}
+
 void UpdateFeeds::saveMemoryDatabase()
 {
   if (!mainApp->storeDBMemory()) return;
@@ -268,10 +354,13 @@ UpdateObject::UpdateObject(QObject *parent)
   : QObject(parent)
   , isSaveMemoryDatabase(false)
   , updateFeedsCount_(0)
+  , skippedParseCount_(0)
 {
   setObjectName("updateObject_");
 
   mainWindow_ = mainApp->mainWindow();
+  // Object is created in GUI thread, later changes come by signal
+  updateSettings_ = mainWindow_->updateSettings();
 
   db_ = Database::connection("secondConnection");
 
@@ -293,33 +382,19 @@ UpdateObject::~UpdateObject()
 void UpdateObject::slotGetFeedTimer(int feedId)
 {
   QSqlQuery q(db_);
-  q.exec(QString("SELECT xmlUrl, lastBuildDate, authentication FROM feeds WHERE id=='%1' AND disableUpdate=0")
+  q.exec(QString("SELECT xmlUrl, authentication FROM feeds WHERE id=='%1' AND disableUpdate=0")
          .arg(feedId));
   if (q.next()) {
-    addFeedInQueue(feedId, q.value(0).toString(),
-                   q.value(1).toDateTime(), q.value(2).toInt());
-  }
-  emit showProgressBar(updateFeedsCount_);
-}
-
-void UpdateObject::slotGetAllFeedsTimer()
-{
-  QSqlQuery q(db_);
-  q.exec("SELECT id, xmlUrl, lastBuildDate, authentication FROM feeds "
-         "WHERE xmlUrl!='' AND disableUpdate=0 "
-         "AND (updateIntervalEnable==-1 OR updateIntervalEnable IS NULL)");
-  while (q.next()) {
-    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(),
-                   q.value(2).toDateTime(), q.value(3).toInt());
+    addFeedInQueue(feedId, q.value(0).toString(), q.value(1).toInt());
   }
   emit showProgressBar(updateFeedsCount_);
 }
 
 /** @brief Process update feed action
  *---------------------------------------------------------------------------*/
-void UpdateObject::slotGetFeed(int feedId, QString feedUrl, QDateTime date, int auth)
+void UpdateObject::slotGetFeed(int feedId, QString feedUrl, int auth)
 {
-  addFeedInQueue(feedId, feedUrl, date, auth);
+  addFeedInQueue(feedId, feedUrl, auth);
 
   emit showProgressBar(updateFeedsCount_);
 }
@@ -331,8 +406,7 @@ void UpdateObject::slotGetFeedsFolder(QString query)
   QSqlQuery q(db_);
   q.exec(query);
   while (q.next()) {
-    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(),
-                   q.value(2).toDateTime(), q.value(3).toInt());
+    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(), q.value(2).toInt());
   }
 
   emit showProgressBar(updateFeedsCount_);
@@ -343,10 +417,9 @@ void UpdateObject::slotGetFeedsFolder(QString query)
 void UpdateObject::slotGetAllFeeds()
 {
   QSqlQuery q(db_);
-  q.exec("SELECT id, xmlUrl, lastBuildDate, authentication FROM feeds WHERE xmlUrl!='' AND disableUpdate=0");
+  q.exec("SELECT id, xmlUrl, authentication FROM feeds WHERE xmlUrl!='' AND disableUpdate=0");
   while (q.next()) {
-    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(),
-                   q.value(2).toDateTime(), q.value(3).toInt());
+    addFeedInQueue(q.value(0).toInt(), q.value(1).toString(), q.value(2).toInt());
   }
   emit showProgressBar(updateFeedsCount_);
 }
@@ -364,40 +437,10 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
   QList<int> idsList;
   QList<QString> urlsList;
   QXmlStreamReader xml;
-  QString convertData;
-  bool codecOk = false;
-
-  QzRegExp rx("&(?!([a-z0-9#]+;))", Qt::CaseInsensitive);
-  int pos = 0;
-  while ((pos = rx.indexIn(QString::fromLatin1(xmlData), pos)) != -1) {
-    xmlData.replace(pos, 1, "&amp;");
-    pos += 1;
-  }
 
-  rx.setPattern("encoding=\"([^\"]+)");
-  pos = rx.indexIn(xmlData);
-  if (pos == -1) {
-    rx.setPattern("encoding='([^']+)");
-    pos = rx.indexIn(xmlData);
-  }
-  if (pos == -1) {
-    QStringList codecNameList;
-    codecNameList << "UTF-8" << "Windows-1251" << "KOI8-R" << "KOI8-U"
-                  << "ISO 8859-5" << "IBM 866";
-    foreach (QString codecNameT, codecNameList) {
-      QTextCodec *codec = QTextCodec::codecForName(codecNameT.toUtf8());
-      if (codec && codec->canEncode(xmlData)) {
-        convertData = codec->toUnicode(xmlData);
-        codecOk = true;
-        break;
-      }
-    }
-  }
-  if (codecOk) {
-    xml.addData(convertData);
-  } else {
-    xml.addData(xmlData);
-  }
+  QString convertData = XmlDecoder::decode(xmlData);
+  convertData.replace(QzRegExp("&(?!([a-z0-9#]+;))", Qt::CaseInsensitive), "&amp;");
+  xml.addData(convertData);
 
   db_.transaction();
 
@@ -410,7 +453,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
     if (xml.isStartElement()) {
       // Search for "outline" only
       if (xml.name() == "outline") {
-        qDebug() << outlineCount << "+:" << xml.prefix().toString()
+        qCDebug(lcDatabase) << outlineCount << "+:" << xml.prefix().toString()
                  << ":" << xml.name().toString();
 
         QString textString(xml.attributes().value("text").toString());
@@ -456,7 +499,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
             isFeedDuplicated = true;
 
           if (isFeedDuplicated) {
-            qDebug() << "duplicate feed:" << xmlUrlString << textString;
+            qCDebug(lcDatabase) << "duplicate feed:" << xmlUrlString << textString;
           } else {
             int rowToParent = 0;
             q.exec(QString("SELECT count(id) FROM feeds WHERE parentId='%1'").
@@ -488,7 +531,7 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
       }
       ++elementCount;
     }
-    qDebug() << parentIdsStack;
+    qCDebug(lcDatabase) << parentIdsStack;
   }
   if (xml.error()) {
     QString error = QString("Import error: Line = %1, Column = %2; Error = %3").
@@ -505,14 +548,13 @@ void UpdateObject::slotImportFeeds(QByteArray xmlData)
 
   for (int i = 0; i < idsList.count(); i++) {
     updateFeedsCount_ = updateFeedsCount_ + 2;
-    emit signalRequestUrl(idsList.at(i), urlsList.at(i), QDateTime(), "");
+    emit signalRequestUrl(idsList.at(i), urlsList.at(i), "", "", "");
   }
   emit showProgressBar(updateFeedsCount_);
 }
 
 // ----------------------------------------------------------------------------
-bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
-                                  const QDateTime &date, int auth)
+bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl, int auth)
 {
   int feedIdIndex = feedIdList_.indexOf(feedId);
   if (feedIdIndex > -1) {
@@ -520,9 +562,18 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
   } else {
     feedIdList_.append(feedId);
     updateFeedsCount_ = updateFeedsCount_ + 2;
+    QSqlQuery q(db_);
+    QString etag;
+    QString lastModified;
+    q.prepare("SELECT etag, lastModified FROM feeds WHERE id=?");
+    q.addBindValue(feedId);
+    q.exec();
+    if (q.next()) {
+      etag = q.value(0).toString();
+      lastModified = q.value(1).toString();
+    }
     QString userInfo;
     if (auth == 1) {
-      QSqlQuery q(db_);
       QUrl url(feedUrl);
       q.prepare("SELECT username, password FROM passwords WHERE server=?");
       q.addBindValue(url.host());
@@ -532,7 +583,7 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
             arg(QString::fromUtf8(QByteArray::fromBase64(q.value(1).toByteArray())));
       }
     }
-    emit signalRequestUrl(feedId, feedUrl, date, userInfo);
+    emit signalRequestUrl(feedId, feedUrl, etag, lastModified, userInfo);
     return true;
   }
 }
@@ -541,9 +592,9 @@ bool UpdateObject::addFeedInQueue(int feedId, const QString &feedUrl,
  *---------------------------------------------------------------------------*/
 void UpdateObject::getUrlDone(int result, int feedId, QString feedUrlStr,
                               QString error, QByteArray data, QDateTime dtReply,
-                              QString codecName)
+                              QString codecName, QString etag, QString lastModified)
 {
-  qDebug() << "getUrl result = " << result << "error: " << error << "url: " << feedUrlStr;
+  qCDebug(lcNetwork) << "getUrl result = " << result << "error: " << error << "url: " << feedUrlStr;
 
   if (updateFeedsCount_ > 0) {
     updateFeedsCount_--;
@@ -551,18 +602,76 @@ void UpdateObject::getUrlDone(int result, int feedId, QString feedUrlStr,
   }
 
   if (!data.isEmpty()) {
-    emit xmlReadyParse(data, feedId, dtReply, codecName);
+    if (mainApp->isRecordCorpus()) {
+      CorpusEntry entry;
+      entry.feedId = feedId;
+      entry.feedUrl = feedUrlStr;
+      entry.dtReply = dtReply;
+      entry.codecName = codecName;
+      entry.etag = etag;
+      entry.lastModified = lastModified;
+      entry.data = data;
+      FeedCorpus::record(entry);
+    }
+
+    QString digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    QString lastDigest;
+    QSqlQuery q(db_);
+    q.exec(QString("SELECT contentDigest FROM feeds WHERE id=='%1'").arg(feedId));
+    if (q.first()) lastDigest = q.value(0).toString();
+
+    // Server ignored conditional request and sent same data again.
+    // Digest is saved after its data is written, so only validators and
+    // check time change
+    if (digest == lastDigest) {
+      q.prepare("UPDATE feeds SET updated=?, lastBuildDate=?, etag=?, lastModified=? "
+                "WHERE id=?");
+      q.addBindValue(QLocale::c().toString(QDateTime::currentDateTimeUtc(),
+                                           "yyyy-MM-ddTHH:mm:ss"));
+      q.addBindValue(dtReply.toString(Qt::ISODate));
+      q.addBindValue(etag);
+      q.addBindValue(lastModified);
+      q.addBindValue(feedId);
+      q.exec();
+
+      skippedParseCount_++;
+      Database::addFeedCounter(db_, feedId, "skippedParses", 1);
+      qCDebug(lcParse) << QString("Data not changed, parsing skipped: url %1, skipped %2").
+                  arg(feedUrlStr).arg(skippedParseCount_);
+      finishUpdate(feedId, false, 0, "0");
+      return;
+    }
+
+    // Validators for conditional request on next update are saved with news
+    emit xmlReadyParse(data, feedId, dtReply, codecName, etag, lastModified, digest);
   } else {
     QString status = "0";
     if (result < 0) {
       status = QString("%1 %2").arg(result).arg(error);
       qWarning() << QString("Request failed: result = %1, error - %2, url - %3").
                     arg(result).arg(error).arg(feedUrlStr);
+    } else {
+      // Not modified, feed is checked like after parsing
+      QSqlQuery q(db_);
+      q.prepare("UPDATE feeds SET updated=?, lastBuildDate=? WHERE id=?");
+      q.addBindValue(QLocale::c().toString(QDateTime::currentDateTimeUtc(),
+                                           "yyyy-MM-ddTHH:mm:ss"));
+      q.addBindValue(dtReply.toString(Qt::ISODate));
+      q.addBindValue(feedId);
+      q.exec();
     }
     finishUpdate(feedId, false, 0, status);
   }
 }
 
+/** @brief Accumulate traffic of feed: bytes on the wire and after decoding
+ *---------------------------------------------------------------------------*/
+void UpdateObject::slotBytesReceived(int feedId, qint64 bytesReceived, qint64 bytesDecoded)
+{
+  Database::addFeedCounter(db_, feedId, "bytesReceived", bytesReceived);
+  Database::addFeedCounter(db_, feedId, "bytesDecoded", bytesDecoded);
+}
+
 void UpdateObject::finishUpdate(int feedId, bool changed, int newCount, QString status)
 {
   if (updateFeedsCount_ > 0) {
@@ -579,10 +688,27 @@ void UpdateObject::finishUpdate(int feedId, bool changed, int newCount, QString
     feedIdList_.takeAt(feedIdIndex);
   }
 
+  // Next automatic update is saved with status, so GUI thread only
+  // puts feed in its queue
+  int publishInterval = feedPublishInterval(feedId, changed);
+  qint64 nextUpdate = 0;
   QSqlQuery q(db_);
-  QString qStr = QString("UPDATE feeds SET status='%1' WHERE id=='%2'").
-      arg(status).arg(feedId);
-  q.exec(qStr);
+  q.exec(QString("SELECT updateIntervalEnable, updateInterval, updateIntervalType "
+                 "FROM feeds WHERE id=='%1' AND xmlUrl!='' AND disableUpdate==0").
+         arg(feedId));
+  if (q.first()) {
+    int interval = MainWindow::feedUpdateInterval(q.value(0), q.value(1).toInt(),
+                                                  q.value(2).toInt(), publishInterval,
+                                                  updateSettings_);
+    if (interval > 0)
+      nextUpdate = Common::currentSecsSinceEpoch() + interval;
+  }
+
+  q.prepare("UPDATE feeds SET status=?, nextUpdate=? WHERE id=?");
+  q.addBindValue(status);
+  q.addBindValue(nextUpdate);
+  q.addBindValue(feedId);
+  q.exec();
 
   if (changed) {
     if (mainWindow_->currentNewsTab->type_ == NewsTabWidget::TabTypeFeed) {
@@ -627,10 +753,51 @@ void UpdateObject::finishUpdate(int feedId, bool changed, int newCount, QString
     }
   }
 
-  emit feedUpdated(feedId, changed, newCount, finish);
+  emit feedUpdated(feedId, changed, newCount, finish, nextUpdate, publishInterval);
   emit setStatusFeed(feedId, status);
 }
 
+/** @brief Learn how often feed publishes news from its latest news
+ * @details Cadence of latest news is read again only when feed got new
+ *   news, silence since newest news is taken into account on every call
+ *---------------------------------------------------------------------------*/
+int UpdateObject::feedPublishInterval(int feedId, bool changed)
+{
+  QHash<int,PublishCadence>::iterator it = publishCadences_.find(feedId);
+  if (changed || (it == publishCadences_.end())) {
+    QList<QDateTime> publishedList;
+    QSqlQuery q(db_);
+    q.prepare("SELECT published FROM news WHERE feedId=? "
+              "ORDER BY published DESC LIMIT ?");
+    q.addBindValue(feedId);
+    q.addBindValue(ADAPTIVE_UPDATE_NEWS_COUNT);
+    q.exec();
+    while (q.next()) {
+      QDateTime published = QDateTime::fromString(q.value(0).toString(), Qt::ISODate);
+      if (published.isValid())
+        publishedList.append(published);
+    }
+
+    PublishCadence cadence;
+    cadence.interval = 0;
+    if (publishedList.count() >= 2) {
+      cadence.newest = publishedList.first();
+      cadence.newest.setTimeSpec(Qt::UTC);
+      cadence.interval = publishedList.last().secsTo(publishedList.first()) /
+          (publishedList.count() - 1);
+    }
+    it = publishCadences_.insert(feedId, cadence);
+  }
+
+  if (!it.value().newest.isValid())
+    return 0;
+
+  // Feed which is silent longer than usual publishes less often now
+  qint64 silence = it.value().newest.secsTo(QDateTime::currentDateTimeUtc());
+  qint64 interval = qMax(it.value().interval, silence / 2);
+  return int(qMin(interval, qint64(2*ADAPTIVE_UPDATE_MAX_INTERVAL)));
+}
+
 /** @brief Start timer if feed presents in queue
  *---------------------------------------------------------------------------*/
 void UpdateObject::slotNextUpdateFeed(bool finish)
@@ -694,20 +861,17 @@ void UpdateObject::slotRecountFeedCounts(int feedId, bool updateViewport)
 
   if (!isFolder) {
     // Calculate all news (not mark deleted)
-    qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-        arg(feedId);
+    qStr = kCountNewsQuery.arg(feedId);
     q.exec(qStr);
     if (q.next()) undeleteCount = q.value(0).toInt();
 
     // Calculate unread news
-    qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-        arg(feedId);
+    qStr = kCountUnreadNewsQuery.arg(feedId);
     q.exec(qStr);
     if (q.next()) unreadCount = q.value(0).toInt();
 
     // Calculate new news
-    qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-        arg(feedId);
+    qStr = kCountNewNewsQuery.arg(feedId);
     q.exec(qStr);
     if (q.next()) newCount = q.value(0).toInt();
 
@@ -760,20 +924,17 @@ void UpdateObject::slotRecountFeedCounts(int feedId, bool updateViewport)
         }
 
         // Calculate all news (not mark deleted)
-        qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-            arg(id);
+        qStr = kCountNewsQuery.arg(id);
         q.exec(qStr);
         if (q.next()) undeleteCount = q.value(0).toInt();
 
         // Calculate unread news
-        qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-            arg(id);
+        qStr = kCountUnreadNewsQuery.arg(id);
         q.exec(qStr);
         if (q.next()) unreadCount = q.value(0).toInt();
 
         // Calculate new news
-        qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-            arg(id);
+        qStr = kCountNewNewsQuery.arg(id);
         q.exec(qStr);
         if (q.next()) newCount = q.value(0).toInt();
 
@@ -1092,7 +1253,7 @@ void UpdateObject::slotMarkReadCategory(int type, int idLabel)
     qStr = "feedId > 0 AND deleted = 0 AND read < 2";
     break;
   case NewsTabWidget::TabTypeStar:
-    qStr = "feedId > 0 AND deleted = 0 AND starred = 1";
+    qStr = kStarredNewsFilter;
     break;
   case NewsTabWidget::TabTypeLabel:
     if (idLabel != 0) {
@@ -1248,7 +1409,7 @@ void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<
       if (q.next()) countAllNews = q.value(0).toInt();
 
       if (fullCleanUp)
-        q.exec(QString("DELETE FROM news WHERE feedId=='%1' AND deleted >= 2").arg(feedId));
+        q.exec(kCleanUpNewsQuery.arg(feedId));
 
       QString qStr1 = QString("UPDATE news SET description='', content='', received='', "
                               "author_name='', author_uri='', author_email='', "
@@ -1301,21 +1462,18 @@ void UpdateObject::startCleanUp(bool isShutdown, QStringList feedsIdList, QList<
       }
 
       int undeleteCount = 0;
-      qStr = QString("SELECT count(id) FROM news WHERE feedId=='%1' AND deleted==0").
-          arg(feedId);
+      qStr = kCountNewsQuery.arg(feedId);
       q.exec(qStr);
       if (q.next()) undeleteCount = q.value(0).toInt();
 
       int unreadCount = 0;
-      qStr = QString("SELECT count(read) FROM news WHERE feedId=='%1' AND read==0 AND deleted==0").
-          arg(feedId);
+      qStr = kCountUnreadNewsQuery.arg(feedId);
       q.exec(qStr);
       if (q.next()) unreadCount = q.value(0).toInt();
 
       int newCount = 0;
       if (!isShutdown) {
-        qStr = QString("SELECT count(new) FROM news WHERE feedId=='%1' AND new==1 AND deleted==0").
-            arg(feedId);
+        qStr = kCountNewNewsQuery.arg(feedId);
         q.exec(qStr);
         if (q.next()) newCount = q.value(0).toInt();
         qStr = QString("UPDATE feeds SET unread='%1', newCount='%2', undeleteCount='%3' WHERE id=='%4'").
@@ -1410,6 +1568,13 @@ void UpdateObject::cleanUpShutdown()
   startCleanUp(true, feedsIdList, foldersIdList);
 }
 
+/** @brief Take changed global settings of automatic update
+ *---------------------------------------------------------------------------*/
+void UpdateObject::setUpdateSettings(UpdateSettings settings)
+{
+  updateSettings_ = settings;
+}
+
 void UpdateObject::quitApp()
 {
   cleanUpShutdown();
@@ -25,10 +25,10 @@
 #include "requestfeed.h"
 #include "parseobject.h"
 #include "faviconobject.h"
+#include "mainwindow.h"
 #include "newstabwidget.h"
 
 class UpdateObject;
-class MainWindow;
 
 class UpdateFeeds : public QObject
 {
@@ -39,6 +39,10 @@ public:
 
   void disconnectObjects();
   void startSaveTimer();
+  void startCorpusReplay();
+  void startUpdateBenchmark();
+  void startDateBenchmark();
+  void startDecoderBenchmark();
 
   UpdateObject *updateObject_;
   RequestFeed *requestFeed_;
@@ -47,6 +51,8 @@ public:
   QThread *getFeedThread_;
   QThread *updateFeedThread_;
   QThread *getFaviconThread_;
+  QList<ParseWorker*> parseWorkers_;
+  QList<QThread*> parseThreads_;
 
 public slots:
   void saveMemoryDatabase();
@@ -55,6 +61,8 @@ signals:
   void signalSaveMemoryDatabase();
 
 private:
+  void startCorpusTask(QObject *task, const QString &threadName);
+
   bool addFeed_;
   QTimer *saveMemoryDBTimer_;
 
@@ -73,15 +81,16 @@ public:
 
 public slots:
   void slotGetFeedTimer(int feedId);
-  void slotGetAllFeedsTimer();
-  void slotGetFeed(int feedId, QString feedUrl, QDateTime date, int auth);
+  void slotGetFeed(int feedId, QString feedUrl, int auth);
   void slotGetFeedsFolder(QString query);
   void slotGetAllFeeds();
   void slotImportFeeds(QByteArray xmlData);
   void getUrlDone(int result, int feedId, QString feedUrlStr,
                   QString error, QByteArray data,
-                  QDateTime dtReply, QString codecName);
+                  QDateTime dtReply, QString codecName,
+                  QString etag, QString lastModified);
   void finishUpdate(int feedId, bool changed, int newCount, QString status);
+  void slotBytesReceived(int feedId, qint64 bytesReceived, qint64 bytesDecoded);
   void slotNextUpdateFeed(bool finish);
   void slotRecountCategoryCounts();
   void slotRecountFeedCounts(int feedId, bool updateViewport = true);
@@ -98,6 +107,7 @@ public slots:
   void startCleanUp(bool isShutdown, QStringList feedsIdList, QList<int> foldersIdList);
   void cleanUpShutdown();
   void quitApp();
+  void setUpdateSettings(UpdateSettings settings);
 
 signals:
   void showProgressBar(int value);
@@ -105,11 +115,15 @@ signals:
   void signalMessageStatusBar(QString message, int timeout = 0);
   void signalUpdateFeedsModel();
   void signalRequestUrl(int feedId, QString urlString,
-                        QDateTime date, QString userInfo);
+                        QString etag, QString lastModified,
+                        QString userInfo);
   void xmlReadyParse(QByteArray data, int feedId,
-                     QDateTime dtReply, QString codecName);
+                     QDateTime dtReply, QString codecName,
+                     QString etag, QString lastModified,
+                     QString contentDigest);
   void setStatusFeed(int feedId, QString status);
-  void feedUpdated(int feedId, bool changed, int newCount, bool finish);
+  void feedUpdated(int feedId, bool changed, int newCount, bool finish,
+                   qint64 nextUpdate, int publishInterval);
   void signalUpdateModel(bool checkFilter = true);
   void signalUpdateNews(int refresh = NewsTabWidget::RefreshInsert);
   void signalCountsStatusBar(int unreadCount, int allCount);
@@ -124,16 +138,24 @@ signals:
   void signalFinishCleanUp(int countDeleted);
 
 private slots:
-  bool addFeedInQueue(int feedId, const QString &feedUrl,
-                      const QDateTime &date, int auth);
+  bool addFeedInQueue(int feedId, const QString &feedUrl, int auth);
 
 private:
   QString getIdFeedsString(int idFolder, int idException = -1);
+  int feedPublishInterval(int feedId, bool changed);
 
   MainWindow *mainWindow_;
+  UpdateSettings updateSettings_;  // copy of global settings of GUI thread
   QSqlDatabase db_;
   QList<int> feedIdList_;
   int updateFeedsCount_;
+  int skippedParseCount_;  // parsing skipped because of unchanged data
+  /** Cadence of feed learned from its latest news */
+  struct PublishCadence {
+    qint64 interval;  // average interval between news, seconds
+    QDateTime newest;
+  };
+  QHash<int,PublishCadence> publishCadences_;
   QTimer *updateModelTimer_;
   QTimer *timerUpdateNews_;
 
@@ -0,0 +1,122 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "xmldecoder.h"
+
+#include <QDebug>
+#include <QTextCodec>
+#include <ctype.h>
+
+/** @brief Value of encoding attribute of XML declaration
+ *----------------------------------------------------------------------------*/
+static QByteArray declaredEncoding(const QByteArray &data)
+{
+  int pos = 0;
+  while ((pos < data.size()) && isspace(static_cast<unsigned char>(data.at(pos))))
+    ++pos;
+  if (data.indexOf("<?xml", pos) != pos)
+    return QByteArray();
+
+  int end = data.indexOf("?>", pos);
+  if (end == -1)
+    return QByteArray();
+  QByteArray declaration = data.mid(pos, end - pos);
+
+  pos = declaration.indexOf("encoding");
+  if (pos == -1)
+    return QByteArray();
+  pos += 8;
+  while ((pos < declaration.size()) && (declaration.at(pos) == ' '))
+    ++pos;
+  if ((pos >= declaration.size()) || (declaration.at(pos) != '='))
+    return QByteArray();
+  ++pos;
+  while ((pos < declaration.size()) && (declaration.at(pos) == ' '))
+    ++pos;
+  if (pos >= declaration.size())
+    return QByteArray();
+
+  char quote = declaration.at(pos);
+  if ((quote != '"') && (quote != '\''))
+    return QByteArray();
+  end = declaration.indexOf(quote, pos + 1);
+  if (end == -1)
+    return QByteArray();
+  return declaration.mid(pos + 1, end - pos - 1).trimmed();
+}
+
+/** @brief Codec of XML data, 0 if encoding isn't specified or is unknown
+ *----------------------------------------------------------------------------*/
+QTextCodec *XmlDecoder::codecForXml(const QByteArray &data, const QString &httpCharset)
+{
+  QTextCodec *codec = QTextCodec::codecForUtfText(data, 0);
+  if (codec)
+    return codec;
+
+  QByteArray name = declaredEncoding(data);
+  // Declaration readable as ASCII can't be in UTF-16/32 without BOM
+  if (!name.isEmpty() && !name.toUpper().startsWith("UTF-16") &&
+      !name.toUpper().startsWith("UTF-32")) {
+    codec = QTextCodec::codecForName(name);
+    if (codec)
+      return codec;
+    qWarning() << "Codec not found (1):" << name;
+  }
+
+  if (!httpCharset.isEmpty()) {
+    codec = QTextCodec::codecForName(httpCharset.toLatin1());
+    if (codec)
+      return codec;
+    qWarning() << "Codec not found (2):" << httpCharset;
+  }
+
+  return 0;
+}
+
+/** @brief Decode XML data with detected codec in one pass
+ *----------------------------------------------------------------------------*/
+QString XmlDecoder::decode(const QByteArray &data, const QString &httpCharset)
+{
+  QTextCodec *codec = codecForXml(data, httpCharset);
+  if (codec)
+    return codec->toUnicode(data);
+
+  QTextCodec::ConverterState state;
+  QString text = QTextCodec::codecForName("UTF-8")->toUnicode(data.constData(),
+                                                               data.size(), &state);
+  if (state.invalidChars == 0)
+    return text;
+  return QString::fromLocal8Bit(data);
+}
+
+/** @brief Check that QXmlStreamReader reading raw data picks detected codec
+ * @details Reader looks only at byte order mark and XML declaration and
+ *   uses UTF-8 without them, so data can be given to it undecoded
+ *----------------------------------------------------------------------------*/
+bool XmlDecoder::isReaderCodec(const QByteArray &data, const QString &httpCharset)
+{
+  QTextCodec *codec = codecForXml(data, httpCharset);
+  if (!codec)
+    return false;
+  if (QTextCodec::codecForUtfText(data, 0))
+    return true;
+
+  QByteArray name = declaredEncoding(data);
+  if (!name.isEmpty())
+    return (QTextCodec::codecForName(name) == codec);
+  return (codec == QTextCodec::codecForName("UTF-8"));
+}
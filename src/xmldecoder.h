@@ -0,0 +1,39 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef XMLDECODER_H
+#define XMLDECODER_H
+
+#include <QByteArray>
+#include <QString>
+
+class QTextCodec;
+
+/** @brief Character set detection and decoding of XML documents
+ *
+ * Encoding is taken from byte order mark, XML declaration or HTTP charset,
+ * in this order, looking only at the document prolog. Without any of them
+ * data is decoded as UTF-8 if valid, otherwise with locale codec
+ *----------------------------------------------------------------------------*/
+namespace XmlDecoder
+{
+  QTextCodec *codecForXml(const QByteArray &data, const QString &httpCharset = QString());
+  QString decode(const QByteArray &data, const QString &httpCharset = QString());
+  bool isReaderCodec(const QByteArray &data, const QString &httpCharset = QString());
+}
+
+#endif // XMLDECODER_H
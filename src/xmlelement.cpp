@@ -0,0 +1,153 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#include "xmlelement.h"
+
+#include <QXmlStreamWriter>
+
+XmlElement::XmlElement()
+{
+}
+
+XmlElement::XmlElement(const QString &tagName, const QXmlStreamAttributes &attributes)
+  : tagName_(tagName)
+  , attributes_(attributes)
+{
+}
+
+/** @brief Read element at current start element of reader with all children
+ *
+ * Whitespace-only text is skipped as QDomDocument does. On return reader
+ * is positioned at end element of read element
+ *----------------------------------------------------------------------------*/
+XmlElement XmlElement::read(QXmlStreamReader &xml)
+{
+  XmlElement element(xml.qualifiedName().toString(), xml.attributes());
+
+  while (!xml.atEnd()) {
+    xml.readNext();
+    if (xml.isStartElement()) {
+      element.children_.append(read(xml));
+    } else if (xml.isCharacters() && !xml.isWhitespace()) {
+      element.children_.append(textNode(xml.text().toString()));
+    } else if (xml.isEndElement()) {
+      break;
+    }
+  }
+  return element;
+}
+
+XmlElement XmlElement::textNode(const QString &text)
+{
+  XmlElement node;
+  node.text_ = text;
+  return node;
+}
+
+QString XmlElement::attribute(const QString &name) const
+{
+  return attributes_.value(name).toString();
+}
+
+/** @brief Text of all descendant text nodes, like QDomElement::text()
+ *----------------------------------------------------------------------------*/
+QString XmlElement::text() const
+{
+  QString text;
+  appendText(&text);
+  return text;
+}
+
+void XmlElement::appendText(QString *text) const
+{
+  if (isNull()) {
+    text->append(text_);
+    return;
+  }
+  foreach (const XmlElement &child, children_) {
+    child.appendText(text);
+  }
+}
+
+/** @brief First child element with tag name, null element if absent
+ *----------------------------------------------------------------------------*/
+XmlElement XmlElement::namedItem(const QString &name) const
+{
+  foreach (const XmlElement &child, children_) {
+    if (child.tagName_ == name)
+      return child;
+  }
+  return XmlElement();
+}
+
+/** @brief All descendant elements with tag name in document order
+ *----------------------------------------------------------------------------*/
+QList<XmlElement> XmlElement::elementsByTagName(const QString &name) const
+{
+  QList<XmlElement> elements;
+  foreach (const XmlElement &child, children_) {
+    child.findElements(name, &elements);
+  }
+  return elements;
+}
+
+void XmlElement::findElements(const QString &name, QList<XmlElement> *elements) const
+{
+  if (isNull())
+    return;
+  if (tagName_ == name)
+    elements->append(*this);
+  foreach (const XmlElement &child, children_) {
+    child.findElements(name, elements);
+  }
+}
+
+/** @brief Element markup including its own tag, like QDomNode::save()
+ *----------------------------------------------------------------------------*/
+QString XmlElement::toString() const
+{
+  if (isNull())
+    return QString();
+
+  QString markup;
+  QXmlStreamWriter writer(&markup);
+  write(&writer);
+  return markup;
+}
+
+void XmlElement::write(QXmlStreamWriter *writer) const
+{
+  if (isNull()) {
+    writer->writeCharacters(text_);
+    return;
+  }
+
+  writer->writeStartElement(tagName_);
+  foreach (const QXmlStreamAttribute &attribute, attributes_) {
+    writer->writeAttribute(attribute.qualifiedName().toString(),
+                           attribute.value().toString());
+  }
+  foreach (const XmlElement &child, children_) {
+    child.write(writer);
+  }
+  writer->writeEndElement();
+}
+
+void XmlElement::appendChild(const XmlElement &child)
+{
+  children_.append(child);
+}
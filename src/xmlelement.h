@@ -0,0 +1,61 @@
+/* ============================================================
+* QuiteRSS is a open-source cross-platform RSS/Atom news feeds reader
+* Copyright (C) 2011-2021 QuiteRSS Team <quiterssteam@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+* ============================================================ */
+#ifndef XMLELEMENT_H
+#define XMLELEMENT_H
+
+#include <QList>
+#include <QString>
+#include <QXmlStreamReader>
+
+/** @brief Lightweight element tree of one feed item
+ *
+ * Subtree is read from QXmlStreamReader, so only the current item is kept
+ * in memory instead of the whole document. Interface follows QDomElement.
+ *----------------------------------------------------------------------------*/
+class XmlElement
+{
+public:
+  XmlElement();
+  XmlElement(const QString &tagName, const QXmlStreamAttributes &attributes);
+
+  static XmlElement read(QXmlStreamReader &xml);
+
+  bool isNull() const { return tagName_.isEmpty(); }
+  QString tagName() const { return tagName_; }
+  QString attribute(const QString &name) const;
+  QString text() const;
+  XmlElement namedItem(const QString &name) const;
+  QList<XmlElement> elementsByTagName(const QString &name) const;
+  QString toString() const;
+
+  void appendChild(const XmlElement &child);
+
+private:
+  static XmlElement textNode(const QString &text);
+  void appendText(QString *text) const;
+  void findElements(const QString &name, QList<XmlElement> *elements) const;
+  void write(QXmlStreamWriter *writer) const;
+
+  QString tagName_;
+  QString text_;        // text node if tagName_ is empty
+  QXmlStreamAttributes attributes_;
+  QList<XmlElement> children_;
+
+};
+
+#endif // XMLELEMENT_H